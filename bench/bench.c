@@ -0,0 +1,274 @@
+/* Microbenchmarks for every API family of the library, printed as one JSON array so the results can be compared across releases
+ Every measurement reports the nanoseconds per operation, the bytes of buffer data touched per second and the allocations per operation.
+ Build: cc -O2 -I../src -I../bench -DCONSTRUCT_ALLOCATOR='"bench_allocator.h"' bench.c ../src/construct.c -o bench
+ Usage: bench [max elements (default 1e8)] [max bytes per buffer (default 1 GiB)] */
+
+#include <time.h>
+#include "construct.h"
+
+/* Minimum CPU time spent on every measurement, repeating the operation until it's reached (on fresh buffers for the operations needing them) */
+#define MIN_CLOCKS (CLOCKS_PER_SEC / 20)
+#define MAX_APPENDS 1000000ul
+#define MAX_REMOVES 256ul
+#define MAX_SORT_ELEMENTS 10000ul
+
+static unsigned long allocations = 0;
+
+void* bench_malloc(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+void* bench_realloc(void* ptr, size_t size)
+{
+    allocations++;
+    return realloc(ptr,size);
+}
+
+void bench_free(void* ptr)
+{
+    free(ptr);
+}
+
+/* Runs one operation family on the target buffer, returns the number of operations and adds the bytes of buffer data touched to bytes */
+typedef unsigned long (*bench_function)(buffer target, unsigned long* bytes);
+
+static unsigned long bench_init_deinit(buffer target, unsigned long* bytes)
+{
+    buffer other = recreate_buffer(target);
+    resize_buffer(other,get_buffer_length(target));
+    deinit_buffer(other);
+    *bytes += get_buffer_size(target);
+    return 1;
+}
+
+static unsigned long bench_get_unbound(buffer target, unsigned long* bytes)
+{
+    unsigned long i, num_elements = get_buffer_length(target);
+    volatile float sum = 0;
+    for (i = 0; i < num_elements; i++)
+        sum += get_buffer_fieldf(target,i,0);
+    *bytes += num_elements * sizeof(float);
+    return num_elements;
+}
+
+static unsigned long bench_set_unbound(buffer target, unsigned long* bytes)
+{
+    unsigned long i, num_elements = get_buffer_length(target);
+    for (i = 0; i < num_elements; i++)
+        set_buffer_fieldf(target,i,0,(float)i);
+    *bytes += num_elements * sizeof(float);
+    return num_elements;
+}
+
+static unsigned long bench_get_bound(buffer target, unsigned long* bytes)
+{
+    unsigned long num_elements = get_buffer_length(target);
+    volatile float sum = 0;
+    while (iterate_over(target))
+        sum += get_fieldf(0);
+    *bytes += num_elements * sizeof(float);
+    return num_elements;
+}
+
+static unsigned long bench_set_bound(buffer target, unsigned long* bytes)
+{
+    unsigned long num_elements = get_buffer_length(target);
+    while (iterate_over(target))
+        set_fieldf(0,(float)get_iterator());
+    *bytes += num_elements * sizeof(float);
+    return num_elements;
+}
+
+static unsigned long bench_append(buffer target, unsigned long* bytes)
+{
+    unsigned long i, num_appends = get_buffer_length(target) < MAX_APPENDS ? get_buffer_length(target) : MAX_APPENDS;
+    buffer dest = recreate_buffer(target);
+    for (i = 0; i < num_appends; i++)
+        append_buffer_element_at(target,i,dest);
+    deinit_buffer(dest);
+    *bytes += num_appends * get_buffer_element_size(target);
+    return num_appends;
+}
+
+static unsigned long bench_remove(buffer target, unsigned long* bytes)
+{
+    unsigned long i, num_removes = get_buffer_length(target) / 2 < MAX_REMOVES ? get_buffer_length(target) / 2 : MAX_REMOVES;
+    for (i = 0; i < num_removes; i++)
+    {
+        *bytes += (get_buffer_length(target) / 2) * get_buffer_element_size(target);
+        remove_buffer_at(target,get_buffer_length(target) / 2);
+    }
+    return num_removes;
+}
+
+static unsigned long bench_sort(buffer target, unsigned long* bytes)
+{
+    if (get_buffer_length(target) > MAX_SORT_ELEMENTS)
+        return 0;
+    sort_buffer_by_field(target,1,0,FLOAT);
+    *bytes += get_buffer_size(target);
+    return 1;
+}
+
+static unsigned long bench_copy(buffer target, unsigned long* bytes)
+{
+    deinit_buffer(copy_buffer(target));
+    *bytes += get_buffer_size(target);
+    return 1;
+}
+
+static unsigned long bench_copy_cow(buffer target, unsigned long* bytes)
+{
+    deinit_buffer(copy_buffer_cow(target));
+    *bytes += get_buffer_size(target);
+    return 1;
+}
+
+static unsigned long bench_copy_to(buffer target, unsigned long* bytes)
+{
+    buffer dest = view_partial_buffer(target,0,get_buffer_length(target) / 2);
+    buffer src = view_partial_buffer(target,get_buffer_length(target) / 2,get_buffer_length(target) / 2);
+    copy_buffer_to_buffer(src,dest);
+    deinit_buffer(src);
+    deinit_buffer(dest);
+    *bytes += get_buffer_size(target);
+    return 1;
+}
+
+static unsigned long bench_dump(buffer target, unsigned long* bytes)
+{
+    free(dump_buffer_binary(target,NULL));
+    *bytes += get_buffer_size(target);
+    return 1;
+}
+
+static unsigned long bench_dump_load(buffer target, unsigned long* bytes)
+{
+    unsigned int size;
+    void* bin_data = dump_buffer_binary(target,&size);
+    load_buffer_binary(target,bin_data,size);
+    free(bin_data);
+    *bytes += 2ul * size;
+    return 2;
+}
+
+static unsigned long bench_add(buffer target, unsigned long* bytes)
+{
+    unsigned long i, num_elements = get_buffer_length(target);
+    for (i = 0; i < num_elements; i++)
+        add_buffer_field(target,i,0,1.0f);
+    *bytes += num_elements * sizeof(float);
+    return num_elements;
+}
+
+static unsigned long bench_mul(buffer target, unsigned long* bytes)
+{
+    unsigned long i, num_elements = get_buffer_length(target);
+    for (i = 0; i < num_elements; i++)
+        mul_buffer_field(target,i,0,1.0001f);
+    *bytes += num_elements * sizeof(float);
+    return num_elements;
+}
+
+struct bench_entry
+{
+    const char* family;
+    const char* op;
+    bench_function function;
+    int needs_fresh_buffer;
+};
+
+static const struct bench_entry benches[] = {
+    {"init",        "init_deinit",              bench_init_deinit, 0},
+    {"field",       "get_buffer_fieldf",        bench_get_unbound, 0},
+    {"field",       "set_buffer_fieldf",        bench_set_unbound, 0},
+    {"field",       "get_fieldf",               bench_get_bound, 0},
+    {"field",       "set_fieldf",               bench_set_bound, 0},
+    {"append",      "append_buffer_element_at", bench_append, 0},
+    {"remove",      "remove_buffer_at",         bench_remove, 1},
+    {"sort",        "sort_buffer_by_field",     bench_sort, 1},
+    {"copy",        "copy_buffer",              bench_copy, 0},
+    {"copy",        "copy_buffer_cow",          bench_copy_cow, 0},
+    {"copy",        "copy_buffer_to_buffer",    bench_copy_to, 0},
+    {"binary",      "dump_buffer_binary",       bench_dump, 0},
+    {"binary",      "dump_load_buffer_binary",  bench_dump_load, 0},
+    {"arithmetic",  "add_buffer_field",         bench_add, 0},
+    {"arithmetic",  "mul_buffer_field",         bench_mul, 0}
+};
+
+static const unsigned int widths[] = {1,4,16};
+
+static buffer create_bench_buffer(unsigned long num_elements, unsigned int num_fields)
+{
+    enum construct_types types[16];
+    unsigned long i;
+    unsigned int field;
+    float* data;
+    buffer target;
+
+    for (field = 0; field < num_fields; field++)
+        types[field] = FLOAT;
+    target = init_bufferve(num_elements,num_fields,types);
+    data = get_buffer_data_buffer(target);
+    for (i = 0; i < num_elements * num_fields; i++)
+        data[i] = (float)((i * 2654435761ul) % 1000);
+    return target;
+}
+
+static int run(const struct bench_entry* bench, unsigned long num_elements, unsigned int num_fields, int first)
+{
+    unsigned long ops = 0, bytes = 0, allocs = 0, repeats = 0, done, before;
+    clock_t start, clocks = 0;
+    double seconds;
+    buffer target = create_bench_buffer(num_elements,num_fields);
+
+    do
+    {
+        if (bench->needs_fresh_buffer && repeats != 0)
+        {
+            deinit_buffer(target);
+            target = create_bench_buffer(num_elements,num_fields);
+        }
+        before = allocations;
+        start = clock();
+        done = bench->function(target,&bytes);
+        clocks += clock() - start;
+        allocs += allocations - before;
+        ops += done;
+        repeats++;
+    } while (done != 0 && clocks < MIN_CLOCKS && repeats < 100000);
+    deinit_buffer(target);
+
+    if (ops == 0)
+        return first;
+
+    seconds = (double)clocks / CLOCKS_PER_SEC;
+    printf("%s\n  {\"family\": \"%s\", \"op\": \"%s\", \"elements\": %lu, \"fields\": %u, \"ns_per_op\": %.3f, \"bytes_per_s\": %.0f, \"allocations_per_op\": %.3f}",
+        first ? "" : ",",bench->family,bench->op,num_elements,num_fields,
+        seconds * 1e9 / ops,seconds > 0 ? bytes / seconds : 0.0,(double)allocs / ops);
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long max_elements = argc > 1 ? strtoul(argv[1],NULL,10) : 100000000ul;
+    unsigned long max_bytes = argc > 2 ? strtoul(argv[2],NULL,10) : 1ul << 30;
+    unsigned long num_elements;
+    unsigned int bench, width;
+    int first = 1;
+
+    printf("[");
+    for (num_elements = 100; num_elements <= max_elements; num_elements *= 10)
+        for (width = 0; width < sizeof(widths) / sizeof(widths[0]); width++)
+        {
+            if (num_elements * widths[width] * sizeof(float) > max_bytes)
+                continue;
+            for (bench = 0; bench < sizeof(benches) / sizeof(benches[0]); bench++)
+                first = run(&benches[bench],num_elements,widths[width],first);
+        }
+    printf("\n]\n");
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef BENCH_ALLOCATOR_H
+#define BENCH_ALLOCATOR_H
+
+/* Routes the allocations of the library through the counting allocator of the benchmark (see CONSTRUCT_ALLOCATOR in construct.c) */
+
+#include <stdlib.h>
+
+void* bench_malloc(size_t size);
+void* bench_realloc(void* ptr, size_t size);
+void bench_free(void* ptr);
+
+#define malloc(X)       bench_malloc(X)
+#define realloc(X,Y)    bench_realloc(X,Y)
+#define free(X)         bench_free(X)
+
+#endif /* BENCH_ALLOCATOR_H */
@@ -0,0 +1,81 @@
+/* Compares the out-of-line accessors against the inline accessors from construct_inline.h and the cursor API
+ Build: cc -O2 -I../src bench_inline.c ../src/construct.c -o bench_inline */
+
+#include <time.h>
+#include "construct_inline.h"
+
+#define NUM_ELEMENTS 10000000
+#define NUM_RUNS 5
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void report(const char* name, double seconds)
+{
+    printf("%-24s %8.3f ns/element\n",name,seconds * 1e9 / ((double)NUM_ELEMENTS * NUM_RUNS));
+}
+
+int main()
+{
+    buffer target = init_bufferva(NUM_ELEMENTS,3,UINT,FLOAT,FLOAT);
+    unsigned int i, run;
+    volatile float sink = 0;
+    float sum;
+    clock_t start;
+    cursor walker;
+
+    for (i = 0; i < NUM_ELEMENTS; i++)
+    {
+        set_buffer_fieldui(target,i,0,i);
+        set_buffer_fieldf(target,i,1,(float)(i % 100));
+        set_buffer_fieldf(target,i,2,0.0f);
+    }
+
+    start = clock();
+    for (run = 0; run < NUM_RUNS; run++)
+    {
+        sum = 0;
+        for (i = 0; i < NUM_ELEMENTS; i++)
+            sum += get_buffer_fieldf(target,i,1);
+        sink += sum;
+    }
+    report("get_buffer_fieldf",seconds_since(start));
+
+    start = clock();
+    for (run = 0; run < NUM_RUNS; run++)
+    {
+        sum = 0;
+        for (i = 0; i < NUM_ELEMENTS; i++)
+            sum += inline_get_buffer_fieldf(target,i,1);
+        sink += sum;
+    }
+    report("inline_get_buffer_fieldf",seconds_since(start));
+
+    start = clock();
+    for (run = 0; run < NUM_RUNS; run++)
+    {
+        sum = 0;
+        open_buffer_cursor(&walker,target,0,NULL);
+        while (cursor_next(&walker))
+            sum += cursor_fieldf(&walker,1);
+        sink += sum;
+    }
+    report("cursor_fieldf",seconds_since(start));
+
+    start = clock();
+    for (run = 0; run < NUM_RUNS; run++)
+        for (i = 0; i < NUM_ELEMENTS; i++)
+            set_buffer_fieldf(target,i,2,get_buffer_fieldf(target,i,1) * 2.0f);
+    report("set_buffer_fieldf",seconds_since(start));
+
+    start = clock();
+    for (run = 0; run < NUM_RUNS; run++)
+        for (i = 0; i < NUM_ELEMENTS; i++)
+            inline_set_buffer_fieldf(target,i,2,inline_get_buffer_fieldf(target,i,1) * 2.0f);
+    report("inline_set_buffer_fieldf",seconds_since(start));
+
+    deinit_buffer(target);
+    return sink < 0;
+}
@@ -0,0 +1,78 @@
+/* Compares the throughput of buffer copies and fills against the byte-at-a-time loops construct used to define, from 64 B up to 1 GB
+ Build: cc -O2 -I../src bench_memcpy.c ../src/construct.c -o bench_memcpy
+ Usage: bench_memcpy [max size in bytes] */
+
+#include <time.h>
+#include "construct.h"
+
+static void* byte_memcpy(void* dest, const void* src, size_t len)
+{
+    volatile char *d = dest;
+    const char *s = src;
+    while (len--)
+        *d++ = *s++;
+    return dest;
+}
+
+static void* byte_memset(void* dest, int val, size_t len)
+{
+    volatile unsigned char *ptr = dest;
+    while (len-- > 0)
+        *ptr++ = val;
+    return dest;
+}
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void report(const char* name, unsigned long size, unsigned long runs, double seconds)
+{
+    printf("%-10s %12lu B %10.2f GB/s\n",name,size,(double)size * runs / (seconds > 0 ? seconds : 1e-9) / 1e9);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long size, max_size = argc > 1 ? strtoul(argv[1],NULL,10) : 1ul << 30;
+    unsigned long run, runs;
+    clock_t start;
+
+    for (size = 64; size <= max_size; size *= 4)
+    {
+        buffer src = init_bufferva(size,1,UCHAR);
+        buffer dest = init_bufferva(size,1,UCHAR);
+        void* src_data = get_buffer_data_buffer(src);
+        void* dest_data = get_buffer_data_buffer(dest);
+        zero_buffer_out(src);
+        zero_buffer_out(dest);
+
+        runs = (1ul << 28) / size;
+        if (runs == 0)
+            runs = 1;
+
+        start = clock();
+        for (run = 0; run < runs; run++)
+            byte_memcpy(dest_data,src_data,size);
+        report("byte copy",size,runs,seconds_since(start));
+
+        start = clock();
+        for (run = 0; run < runs; run++)
+            copy_buffer_to_buffer(src,dest);
+        report("copy",size,runs,seconds_since(start));
+
+        start = clock();
+        for (run = 0; run < runs; run++)
+            byte_memset(dest_data,0,size);
+        report("byte zero",size,runs,seconds_since(start));
+
+        start = clock();
+        for (run = 0; run < runs; run++)
+            zero_buffer_out(dest);
+        report("zero",size,runs,seconds_since(start));
+
+        deinit_buffer(src);
+        deinit_buffer(dest);
+    }
+    return 0;
+}
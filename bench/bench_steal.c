@@ -0,0 +1,114 @@
+/* Compares static partitioning against the work-stealing thread pool on a transform whose cost per element is heavily skewed
+ Static partitioning hands every thread one contiguous block, work stealing runs small blocks (through parallel_for_buffer) and recursively split ranges (through construct_spawn/construct_sync).
+ Build: cc -O2 -DCONSTRUCT_THREADS -I../src bench_steal.c ../src/construct.c -o bench_steal -lpthread
+ Usage: bench_steal [max threads (default 8)] */
+
+#define _POSIX_C_SOURCE 199309L
+#include <time.h>
+#include "construct_inline.h"
+
+#define NUM_ELEMENTS 2000000
+#define NUM_RUNS 5
+#define SPLIT_ELEMENTS 1024
+
+/* Elements of the first eighth of the buffer cost this many times as much as the others, like elements pointing to large nested buffers would */
+#define SKEW 64
+
+static double seconds_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void transform(void* data, unsigned int start, unsigned int count, unsigned int stride, void* user)
+{
+    unsigned int i, k;
+    (void)start;
+    (void)user;
+    for (i = 0; i < count; i++)
+    {
+        unsigned int* cost = (unsigned int*)((unsigned char*)data + stride * i);
+        float* value = (float*)(cost + 1);
+        float sum = *value;
+        for (k = 0; k < *cost; k++)
+            sum = sum * 0.999f + 1.0f;
+        *value = sum;
+    }
+}
+
+static void transform_range(buffer target, unsigned int start, unsigned int count, void* user)
+{
+    struct construct_task_group* group = user;
+    while (count > SPLIT_ELEMENTS)
+    {
+        construct_spawn(group,transform_range,target,start + count / 2,count - count / 2,user);
+        count /= 2;
+    }
+    transform((unsigned char*)inline_get_buffer_element_pointer(target,start),start,count,inline_get_buffer_stride(target),NULL);
+}
+
+static double run_static(buffer target, unsigned int num_threads)
+{
+    double start = seconds_now();
+    unsigned int run;
+    for (run = 0; run < NUM_RUNS; run++)
+        parallel_for_buffer(target,transform,(NUM_ELEMENTS + num_threads - 1) / num_threads,NULL);
+    return (seconds_now() - start) / NUM_RUNS;
+}
+
+static double run_blocks(buffer target, unsigned int num_threads)
+{
+    double start = seconds_now();
+    unsigned int run;
+    (void)num_threads;
+    for (run = 0; run < NUM_RUNS; run++)
+        parallel_for_buffer(target,transform,SPLIT_ELEMENTS,NULL);
+    return (seconds_now() - start) / NUM_RUNS;
+}
+
+static double run_spawn(buffer target, unsigned int num_threads)
+{
+    double start = seconds_now();
+    unsigned int run;
+    (void)num_threads;
+    for (run = 0; run < NUM_RUNS; run++)
+    {
+        struct construct_task_group group = CONSTRUCT_TASK_GROUP_INIT;
+        transform_range(target,0,NUM_ELEMENTS,&group);
+        construct_sync(&group);
+    }
+    return (seconds_now() - start) / NUM_RUNS;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int max_threads = argc > 1 ? (unsigned int)strtoul(argv[1],NULL,10) : 8;
+    unsigned int i, num_threads;
+    int first = 1;
+    buffer target = init_bufferva(NUM_ELEMENTS,2,UINT,FLOAT);
+
+    for (i = 0; i < NUM_ELEMENTS; i++)
+    {
+        set_buffer_fieldui(target,i,0,i < NUM_ELEMENTS / 8 ? SKEW : 1);
+        set_buffer_fieldf(target,i,1,0.0f);
+    }
+
+    printf("[");
+    for (num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        double seconds[3];
+        init_thread_pool(num_threads);
+        seconds[0] = run_static(target,num_threads);
+        seconds[1] = run_blocks(target,num_threads);
+        seconds[2] = run_spawn(target,num_threads);
+        printf("%s\n  {\"threads\": %u, \"static_ms\": %.3f, \"stealing_blocks_ms\": %.3f, \"stealing_spawn_ms\": %.3f, \"speedup\": %.2f}",
+            first ? "" : ",",num_threads,seconds[0] * 1e3,seconds[1] * 1e3,seconds[2] * 1e3,seconds[0] / (seconds[1] < seconds[2] ? seconds[1] : seconds[2]));
+        fflush(stdout);
+        first = 0;
+    }
+    printf("\n]\n");
+    deinit_thread_pool();
+    deinit_buffer(target);
+    return 0;
+}
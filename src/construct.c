@@ -14,6 +14,12 @@ enum ERRORS
     ERROR_NO_BOUND_BUFFER,
     ERROR_INVALID_INDEX,
     ERROR_BAD_TYPES,
+    ERROR_RESIZED_VIEW,
+    ERROR_SHARED_VIEW,
+    ERROR_STALE_BATCH,
+    ERROR_LONG_STRING,
+    ERROR_FULL_DICTIONARY,
+    ERROR_ARENA_BUFFER,
     NUM_ERROR_MESSAGES
 };
 
@@ -30,55 +36,539 @@ const char* ERROR_MESSAGES[NUM_ERROR_MESSAGES] = {
     "ERROR_INVALID_NUM_TYPES",
     "ERROR_NO_BOUND_BUFFER",
     "ERROR_BAD_TYPES",
-    "ERROR_INVALID_INDEX"
+    "ERROR_INVALID_INDEX",
+    "ERROR_RESIZED_VIEW",
+    "ERROR_SHARED_VIEW",
+    "ERROR_STALE_BATCH",
+    "ERROR_LONG_STRING",
+    "ERROR_FULL_DICTIONARY",
+    "ERROR_ARENA_BUFFER"
 };
 
 #define cast_to(type) *(type*)
 #define NULL ((void*)0)
 
-struct buffer
-{
-    unsigned int iterator,num_types,num_elements;
-    void* data_buffer;
-    enum construct_types* types;
-};
-
 typedef struct buffer* buffer;
+typedef struct ring* ring;
+typedef struct appender* appender;
+typedef struct versioned* versioned;
 
 buffer CURRENT_BUFFER = NULL;
 enum construct_types* CURRENT_TYPES = NULL;
 unsigned int CURRENT_NUM_TYPES = 0;
-static const unsigned int sizes[6] = {sizeof(unsigned int),sizeof(int),sizeof(float),sizeof(char),sizeof(unsigned char),sizeof(void*)};
+static const unsigned int sizes[20] = {sizeof(unsigned int),sizeof(int),sizeof(float),sizeof(char),sizeof(unsigned char),sizeof(void*),
+    sizeof(signed char),sizeof(short),sizeof(unsigned short),sizeof(long long),sizeof(unsigned long long),sizeof(double),sizeof(unsigned short),0,
+    16,32,sizeof(unsigned int),sizeof(unsigned char),sizeof(unsigned short),sizeof(void*)};
 
 void error_if(int failure, enum ERRORS error, const char* function);
 unsigned int util_get_size(buffer target);
 unsigned int util_get_size_until(buffer target, unsigned int num_fields);
+buffer util_create_buffer(unsigned int num_elements, unsigned int num_types, enum construct_types* types);
+buffer util_create_buffer_like(unsigned int num_elements, buffer src);
+void util_create_dictionaries(buffer target);
+void util_share_dictionaries(buffer dest, buffer src);
+void util_release_dictionaries(buffer target);
+void util_free_arena(buffer target);
+enum construct_types* util_copy_types(buffer target);
+unsigned int* util_compute_offsets(unsigned int num_types, enum construct_types* types);
+void util_copy_elements(buffer dest, unsigned int destidx, buffer src, unsigned int srcidx, unsigned int num_elements);
+void util_zero_elements(buffer target, unsigned int index, unsigned int num_elements);
+void util_prepare_write(buffer target);
+void util_copy_fields(void* dest, unsigned int dest_stride, const unsigned int* dest_offsets, const void* src, unsigned int src_stride, const unsigned int* src_offsets, buffer layout, unsigned int num_elements);
 void swap(void* src1, void* src2, unsigned int size);
+void util_register_buffer(buffer target);
+void util_unregister_buffer(buffer target);
+void util_track_footprint(buffer target);
+void util_account_bytes(long bytes);
+
+/* Relaxed atomics for counters which may be updated from multiple threads at once */
+#if defined(__GNUC__)
+    #define util_atomic_add(counter,amount)     __atomic_fetch_add(&(counter),(amount),__ATOMIC_RELAXED)
+    #define util_atomic_load(counter)           __atomic_load_n(&(counter),__ATOMIC_RELAXED)
+    #define util_atomic_store(counter,value)    __atomic_store_n(&(counter),(value),__ATOMIC_RELAXED)
+#else
+    #define util_atomic_add(counter,amount)     ((counter) += (amount))
+    #define util_atomic_load(counter)           (counter)
+    #define util_atomic_store(counter,value)    ((counter) = (value))
+#endif
+
+/* Reference counts of shared data buffers and of the views of a buffer, which copies and views living on different threads may change at once */
+#ifdef CONSTRUCT_THREADS
+    #define util_acquire_reference(counter)     __atomic_add_fetch(&(counter),1,__ATOMIC_RELAXED)
+    #define util_release_reference(counter)     __atomic_sub_fetch(&(counter),1,__ATOMIC_ACQ_REL)
+    #define util_load_references(counter)       __atomic_load_n(&(counter),__ATOMIC_ACQUIRE)
+#else
+    #define util_acquire_reference(counter)     (++(counter))
+    #define util_release_reference(counter)     (--(counter))
+    #define util_load_references(counter)       (counter)
+#endif
+
+/* The allocation profiler times calls with clock_gettime(), which strict ISO builds (like -std=c89) only declare for POSIX sources */
+#if defined(CONSTRUCT_PROFILE) && !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+    #define _POSIX_C_SOURCE 199309L
+#endif
 
 #define CONSTRUCT_IMPLEMENTATION
-#include "construct.h"
+#include "construct_inline.h"
 
+#include <string.h>
+
+/* Defining "CONSTRUCT_ALLOCATOR" as a header name (-DCONSTRUCT_ALLOCATOR='"my_allocator.h"') lets that header redefine malloc, realloc and free for the library, just like DBG does in debug builds */
 #ifdef EBUG
     #include <DBG/debug.h>
+#elif defined(CONSTRUCT_ALLOCATOR)
+    #include CONSTRUCT_ALLOCATOR
+#endif
+
+/* Defining "CONSTRUCT_PROFILE" routes every allocation of the library through a layer counting calls, bytes, realloc chains and time per call site (on top of DBG or "CONSTRUCT_ALLOCATOR" if those are used as well) */
+#ifdef CONSTRUCT_PROFILE
+    #include <time.h>
+
+    #ifndef CONSTRUCT_PROFILE_SITES
+        #define CONSTRUCT_PROFILE_SITES 256
+    #endif
+
+    #ifdef EBUG
+        #define util_profile_alloc(size,file,line)          DEBUG_MEMmalloc(size,(char*)(file),line)
+        #define util_profile_realloc_to(ptr,size,file,line) DEBUG_MEMrealloc(ptr,size,(char*)(file),line)
+        #define util_profile_release(ptr,file,line)         DEBUG_MEMfree(ptr,(char*)(file),line)
+    #else
+        #define util_profile_alloc(size,file,line)          malloc(size)
+        #define util_profile_realloc_to(ptr,size,file,line) realloc(ptr,size)
+        #define util_profile_release(ptr,file,line)         free(ptr)
+    #endif
+
+    struct profile_site
+    {
+        const char* file;
+        const char* function;
+        unsigned int line;
+        unsigned long allocations,reallocs,frees,bytes,grown_bytes,longest_chain;
+        double nanoseconds;
+    };
+
+    struct profile_block
+    {
+        void* ptr;
+        size_t size;
+        unsigned long chain;
+    };
+
+    static struct profile_site PROFILE_SITES[CONSTRUCT_PROFILE_SITES], PROFILE_OVERFLOW;
+    static struct profile_block* PROFILE_BLOCKS = NULL;
+    static unsigned long PROFILE_NUM_BLOCKS = 0, PROFILE_BLOCK_CAPACITY = 0;
+
+    /* Returns the wall time in nanoseconds, or the processor time of the whole process on platforms without a monotonic clock */
+    static double util_profile_now()
+    {
+        #ifdef CLOCK_MONOTONIC
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC,&now);
+        return now.tv_sec * 1e9 + now.tv_nsec;
+        #else
+        return clock() * (1e9 / CLOCKS_PER_SEC);
+        #endif
+    }
+
+    static struct profile_site* util_profile_site(const char* file, const char* function, unsigned int line)
+    {
+        unsigned int i, index;
+        for (i = 0; i < CONSTRUCT_PROFILE_SITES; i++)
+        {
+            index = (line + i) % CONSTRUCT_PROFILE_SITES;
+            if (PROFILE_SITES[index].function == function && PROFILE_SITES[index].line == line)
+                return &PROFILE_SITES[index];
+            if (PROFILE_SITES[index].function == NULL)
+            {
+                PROFILE_SITES[index].file = file;
+                PROFILE_SITES[index].function = function;
+                PROFILE_SITES[index].line = line;
+                return &PROFILE_SITES[index];
+            }
+        }
+        /* Once every site is taken, the remaining ones are counted together instead of into some unrelated site */
+        PROFILE_OVERFLOW.file = "(overflow)";
+        PROFILE_OVERFLOW.function = "(other call sites)";
+        return &PROFILE_OVERFLOW;
+    }
+
+    static void util_profile_shutdown()
+    {
+        free(PROFILE_BLOCKS);
+        PROFILE_BLOCKS = NULL;
+        PROFILE_NUM_BLOCKS = 0;
+        PROFILE_BLOCK_CAPACITY = 0;
+    }
+
+    static unsigned long util_profile_slot(void* ptr)
+    {
+        return (unsigned long)(((size_t)ptr >> 4) * 2654435761u) & (PROFILE_BLOCK_CAPACITY - 1);
+    }
+
+    static void util_profile_insert(void* ptr, size_t size, unsigned long chain)
+    {
+        unsigned long i;
+        if (ptr == NULL)
+            return;
+        if ((PROFILE_NUM_BLOCKS + 1) * 2 > PROFILE_BLOCK_CAPACITY)
+        {
+            struct profile_block* old_blocks = PROFILE_BLOCKS;
+            unsigned long old_capacity = PROFILE_BLOCK_CAPACITY;
+            if (old_blocks == NULL)
+                atexit(util_profile_shutdown);
+            PROFILE_BLOCK_CAPACITY = old_capacity == 0 ? 1024 : old_capacity * 2;
+            PROFILE_BLOCKS = malloc(sizeof(struct profile_block) * PROFILE_BLOCK_CAPACITY);
+            memset(PROFILE_BLOCKS,0,sizeof(struct profile_block) * PROFILE_BLOCK_CAPACITY);
+            PROFILE_NUM_BLOCKS = 0;
+            for (i = 0; i < old_capacity; i++)
+                if (old_blocks[i].ptr != NULL)
+                    util_profile_insert(old_blocks[i].ptr,old_blocks[i].size,old_blocks[i].chain);
+            free(old_blocks);
+        }
+        for (i = util_profile_slot(ptr); PROFILE_BLOCKS[i].ptr != NULL; i = (i + 1) & (PROFILE_BLOCK_CAPACITY - 1));
+        PROFILE_BLOCKS[i].ptr = ptr;
+        PROFILE_BLOCKS[i].size = size;
+        PROFILE_BLOCKS[i].chain = chain;
+        PROFILE_NUM_BLOCKS++;
+    }
+
+    static struct profile_block util_profile_remove(void* ptr)
+    {
+        struct profile_block block = {NULL,0,0};
+        unsigned long i, j, mask = PROFILE_BLOCK_CAPACITY - 1;
+        if (ptr == NULL || PROFILE_BLOCKS == NULL)
+            return block;
+        for (i = util_profile_slot(ptr); PROFILE_BLOCKS[i].ptr != ptr; i = (i + 1) & mask)
+            if (PROFILE_BLOCKS[i].ptr == NULL)
+                return block;
+        block = PROFILE_BLOCKS[i];
+        PROFILE_NUM_BLOCKS--;
+        for (j = (i + 1) & mask; PROFILE_BLOCKS[j].ptr != NULL; j = (j + 1) & mask)
+        {
+            unsigned long home = util_profile_slot(PROFILE_BLOCKS[j].ptr);
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+                PROFILE_BLOCKS[i] = PROFILE_BLOCKS[j];
+                i = j;
+            }
+        }
+        PROFILE_BLOCKS[i].ptr = NULL;
+        return block;
+    }
+
+    static void* util_profile_malloc(size_t size, const char* file, const char* function, unsigned int line)
+    {
+        double start = util_profile_now();
+        void* ptr = util_profile_alloc(size,file,line);
+        struct profile_site* site = util_profile_site(file,function,line);
+        site->nanoseconds += util_profile_now() - start;
+        site->allocations++;
+        site->bytes += size;
+        util_profile_insert(ptr,size,0);
+        return ptr;
+    }
+
+    static void* util_profile_realloc(void* old_ptr, size_t size, const char* file, const char* function, unsigned int line)
+    {
+        struct profile_block block = util_profile_remove(old_ptr);
+        double start = util_profile_now();
+        void* ptr = util_profile_realloc_to(old_ptr,size,file,line);
+        struct profile_site* site = util_profile_site(file,function,line);
+        site->nanoseconds += util_profile_now() - start;
+        if (ptr == NULL)
+        {
+            util_profile_insert(block.ptr,block.size,block.chain);
+            return ptr;
+        }
+        site->reallocs++;
+        site->bytes += size;
+        if (size > block.size)
+            site->grown_bytes += size - block.size;
+        if (block.chain + 1 > site->longest_chain)
+            site->longest_chain = block.chain + 1;
+        util_profile_insert(ptr,size,block.chain + 1);
+        return ptr;
+    }
+
+    static void util_profile_free(void* ptr, const char* file, const char* function, unsigned int line)
+    {
+        if (ptr != NULL)
+            util_profile_remove(ptr);
+        double start = util_profile_now();
+        util_profile_release(ptr,file,line);
+        struct profile_site* site = util_profile_site(file,function,line);
+        site->nanoseconds += util_profile_now() - start;
+        if (ptr != NULL)
+            site->frees++;
+    }
+
+    #undef malloc
+    #undef realloc
+    #undef free
+    #define malloc(X)       util_profile_malloc(X,__FILE__,__FUNCTION__,__LINE__)
+    #define realloc(X,Y)    util_profile_realloc(X,Y,__FILE__,__FUNCTION__,__LINE__)
+    #define free(X)         util_profile_free(X,__FILE__,__FUNCTION__,__LINE__)
+#endif
+
+/* The profiling layer and DBG keep global tables of the live allocations, so with "CONSTRUCT_THREADS" every allocation through them takes a lock, letting the threads of the thread pool allocate as well */
+#if defined(CONSTRUCT_THREADS) && (defined(CONSTRUCT_PROFILE) || defined(EBUG))
+    #include <pthread.h>
+
+    static pthread_mutex_t ALLOCATION_LOCK = PTHREAD_MUTEX_INITIALIZER;
+    #define util_lock_allocations()     pthread_mutex_lock(&ALLOCATION_LOCK)
+    #define util_unlock_allocations()   pthread_mutex_unlock(&ALLOCATION_LOCK)
+
+    #ifdef CONSTRUCT_PROFILE
+        #define util_locked_alloc(size,file,function,line)          util_profile_malloc(size,file,function,line)
+        #define util_locked_realloc_to(ptr,size,file,function,line) util_profile_realloc(ptr,size,file,function,line)
+        #define util_locked_release(ptr,file,function,line)         util_profile_free(ptr,file,function,line)
+    #else
+        #define util_locked_alloc(size,file,function,line)          DEBUG_MEMmalloc(size,(char*)(file),line)
+        #define util_locked_realloc_to(ptr,size,file,function,line) DEBUG_MEMrealloc(ptr,size,(char*)(file),line)
+        #define util_locked_release(ptr,file,function,line)         DEBUG_MEMfree(ptr,(char*)(file),line)
+    #endif
+
+    static void* util_locked_malloc(size_t size, const char* file, const char* function, unsigned int line)
+    {
+        void* ptr;
+        (void)function;
+        util_lock_allocations();
+        ptr = util_locked_alloc(size,file,function,line);
+        util_unlock_allocations();
+        return ptr;
+    }
+
+    static void* util_locked_realloc(void* old_ptr, size_t size, const char* file, const char* function, unsigned int line)
+    {
+        void* ptr;
+        (void)function;
+        util_lock_allocations();
+        ptr = util_locked_realloc_to(old_ptr,size,file,function,line);
+        util_unlock_allocations();
+        return ptr;
+    }
+
+    static void util_locked_free(void* ptr, const char* file, const char* function, unsigned int line)
+    {
+        (void)function;
+        util_lock_allocations();
+        util_locked_release(ptr,file,function,line);
+        util_unlock_allocations();
+    }
+
+    #undef malloc
+    #undef realloc
+    #undef free
+    #define malloc(X)       util_locked_malloc(X,__FILE__,__FUNCTION__,__LINE__)
+    #define realloc(X,Y)    util_locked_realloc(X,Y,__FILE__,__FUNCTION__,__LINE__)
+    #define free(X)         util_locked_free(X,__FILE__,__FUNCTION__,__LINE__)
 #else
-    void* memset(void* dest, int val, size_t len)
+    #define util_lock_allocations()
+    #define util_unlock_allocations()
+#endif
+
+/* Copies and fills of at least this many bytes bypass the caches with non-temporal stores, as the data would only evict everything else anyway */
+#ifndef CONSTRUCT_STREAM_THRESHOLD
+    #define CONSTRUCT_STREAM_THRESHOLD (8u << 20)
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define UTIL_STREAM_KERNELS
+    #include <immintrin.h>
+
+    __attribute__((target("avx2"))) static void util_stream_copy_avx2(unsigned char* dest, const unsigned char* src, size_t len)
+    {
+        size_t head = (32 - ((size_t)dest & 31)) & 31;
+        memcpy(dest,src,head);
+        dest += head;
+        src += head;
+        len -= head;
+        for (; len >= 128; len -= 128, dest += 128, src += 128)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*)src);
+            __m256i b = _mm256_loadu_si256((const __m256i*)(src + 32));
+            __m256i c = _mm256_loadu_si256((const __m256i*)(src + 64));
+            __m256i d = _mm256_loadu_si256((const __m256i*)(src + 96));
+            _mm256_stream_si256((__m256i*)dest,a);
+            _mm256_stream_si256((__m256i*)(dest + 32),b);
+            _mm256_stream_si256((__m256i*)(dest + 64),c);
+            _mm256_stream_si256((__m256i*)(dest + 96),d);
+        }
+        _mm_sfence();
+        memcpy(dest,src,len);
+    }
+
+    __attribute__((target("avx2"))) static void util_stream_set_avx2(unsigned char* dest, int val, size_t len)
+    {
+        size_t head = (32 - ((size_t)dest & 31)) & 31;
+        __m256i v = _mm256_set1_epi8((char)val);
+        memset(dest,val,head);
+        dest += head;
+        len -= head;
+        for (; len >= 128; len -= 128, dest += 128)
+        {
+            _mm256_stream_si256((__m256i*)dest,v);
+            _mm256_stream_si256((__m256i*)(dest + 32),v);
+            _mm256_stream_si256((__m256i*)(dest + 64),v);
+            _mm256_stream_si256((__m256i*)(dest + 96),v);
+        }
+        _mm_sfence();
+        memset(dest,val,len);
+    }
+
+    __attribute__((target("sse2"))) static void util_stream_copy_sse2(unsigned char* dest, const unsigned char* src, size_t len)
+    {
+        size_t head = (16 - ((size_t)dest & 15)) & 15;
+        memcpy(dest,src,head);
+        dest += head;
+        src += head;
+        len -= head;
+        for (; len >= 64; len -= 64, dest += 64, src += 64)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)src);
+            __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+            __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+            _mm_stream_si128((__m128i*)dest,a);
+            _mm_stream_si128((__m128i*)(dest + 16),b);
+            _mm_stream_si128((__m128i*)(dest + 32),c);
+            _mm_stream_si128((__m128i*)(dest + 48),d);
+        }
+        _mm_sfence();
+        memcpy(dest,src,len);
+    }
+
+    __attribute__((target("sse2"))) static void util_stream_set_sse2(unsigned char* dest, int val, size_t len)
+    {
+        size_t head = (16 - ((size_t)dest & 15)) & 15;
+        __m128i v = _mm_set1_epi8((char)val);
+        memset(dest,val,head);
+        dest += head;
+        len -= head;
+        for (; len >= 64; len -= 64, dest += 64)
+        {
+            _mm_stream_si128((__m128i*)dest,v);
+            _mm_stream_si128((__m128i*)(dest + 16),v);
+            _mm_stream_si128((__m128i*)(dest + 32),v);
+            _mm_stream_si128((__m128i*)(dest + 48),v);
+        }
+        _mm_sfence();
+        memset(dest,val,len);
+    }
+
+    static void (*util_stream_copy)(unsigned char* dest, const unsigned char* src, size_t len) = NULL;
+    static void (*util_stream_set)(unsigned char* dest, int val, size_t len) = NULL;
+
+    static void util_select_stream_kernels()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            util_stream_set = util_stream_set_avx2;
+            util_stream_copy = util_stream_copy_avx2;
+        }
+        else if (__builtin_cpu_supports("sse2"))
+        {
+            util_stream_set = util_stream_set_sse2;
+            util_stream_copy = util_stream_copy_sse2;
+        }
+    }
+#endif
+
+void* util_memcpy(void* dest, const void* src, size_t len)
+{
+    #ifdef UTIL_STREAM_KERNELS
+    if (len >= CONSTRUCT_STREAM_THRESHOLD)
+    {
+        if (util_stream_copy == NULL)
+            util_select_stream_kernels();
+        if (util_stream_copy != NULL)
+        {
+            util_stream_copy(dest,src,len);
+            return dest;
+        }
+    }
+    #endif
+    return memcpy(dest,src,len);
+}
+
+void* util_memset(void* dest, int val, size_t len)
+{
+    #ifdef UTIL_STREAM_KERNELS
+    if (len >= CONSTRUCT_STREAM_THRESHOLD)
+    {
+        if (util_stream_set == NULL)
+            util_select_stream_kernels();
+        if (util_stream_set != NULL)
+        {
+            util_stream_set(dest,val,len);
+            return dest;
+        }
+    }
+    #endif
+    return memset(dest,val,len);
+}
+
+/* Half conversions use the F16C instructions where the CPU has them, 8 values at a time */
+#ifdef UTIL_STREAM_KERNELS
+    __attribute__((target("avx,f16c"))) static void util_halves_to_floats_f16c(const unsigned short* src, float* dest, unsigned int num_values)
+    {
+        unsigned int i;
+        for (i = 0; i + 8 <= num_values; i += 8)
+            _mm256_storeu_ps(dest + i,_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+        for (; i < num_values; i++)
+            dest[i] = half_to_float(src[i]);
+    }
+
+    __attribute__((target("avx,f16c"))) static void util_floats_to_halves_f16c(const float* src, unsigned short* dest, unsigned int num_values)
     {
-        unsigned char *ptr = dest;
-        while (len-- > 0)
-            *ptr++ = val;
-        return dest;
+        unsigned int i;
+        for (i = 0; i + 8 <= num_values; i += 8)
+            _mm_storeu_si128((__m128i*)(dest + i),_mm256_cvtps_ph(_mm256_loadu_ps(src + i),_MM_FROUND_TO_NEAREST_INT));
+        for (; i < num_values; i++)
+            dest[i] = float_to_half(src[i]);
     }
 
-    void* memcpy(void* dest, const void* src, size_t len)
+    static int util_has_f16c()
     {
-        char *d = dest;
-        const char *s = src;
-        while (len--)
-            *d++ = *s++;
-        return dest;
+        static int has_f16c = -1;
+        if (has_f16c == -1)
+        {
+            __builtin_cpu_init();
+            has_f16c = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+        }
+        return has_f16c;
     }
 #endif
 
+void util_halves_to_floats(unsigned short* src, float* dest, unsigned int num_values)
+{
+    unsigned int i;
+    #ifdef UTIL_STREAM_KERNELS
+    if (util_has_f16c())
+    {
+        util_halves_to_floats_f16c(src,dest,num_values);
+        return;
+    }
+    #endif
+    for (i = 0; i < num_values; i++)
+        dest[i] = half_to_float(src[i]);
+}
+
+void util_floats_to_halves(float* src, unsigned short* dest, unsigned int num_values)
+{
+    unsigned int i;
+    #ifdef UTIL_STREAM_KERNELS
+    if (util_has_f16c())
+    {
+        util_floats_to_halves_f16c(src,dest,num_values);
+        return;
+    }
+    #endif
+    for (i = 0; i < num_values; i++)
+        dest[i] = float_to_half(src[i]);
+}
+
 void error_if(int failure, unsigned int error, const char* function)
 {
     if (failure)
@@ -90,20 +580,208 @@ void error_if(int failure, unsigned int error, const char* function)
 
 #define error_if(failure,error)     error_if(failure,error,__FUNCTION__);
 
+void util_error_long_string()
+{
+    error_if(1,ERROR_LONG_STRING);
+}
+
+#ifdef CONSTRUCT_STATS
+    struct construct_stats GLOBAL_STATS;
+    #define count_buffer_stat(target,counter,amount)    util_atomic_add((target)->stats.counter,(amount))
+    #define count_stat(target,counter,amount)           { count_buffer_stat(target,counter,amount); util_atomic_add(GLOBAL_STATS.counter,(amount)); }
+#else
+    #define count_buffer_stat(target,counter,amount)
+    #define count_stat(target,counter,amount)
+#endif
+
+#ifdef CONSTRUCT_REGISTRY
+    buffer REGISTRY = NULL;
+    unsigned int REGISTRY_NUM_BUFFERS = 0;
+    unsigned long REGISTRY_BYTES = 0, REGISTRY_PEAK_BYTES = 0;
+    /* With "CONSTRUCT_THREADS" every thread may create and deinitialise buffers, so the list and the byte counts are only touched under a lock and every thread records its own call site */
+    #ifdef CONSTRUCT_THREADS
+        #include <pthread.h>
+
+        static pthread_mutex_t REGISTRY_LOCK = PTHREAD_MUTEX_INITIALIZER;
+        #define util_lock_registry()        pthread_mutex_lock(&REGISTRY_LOCK)
+        #define util_unlock_registry()      pthread_mutex_unlock(&REGISTRY_LOCK)
+        __thread const char* REGISTRY_FILE = NULL;
+        __thread unsigned int REGISTRY_LINE = 0;
+    #else
+        #define util_lock_registry()
+        #define util_unlock_registry()
+        const char* REGISTRY_FILE = NULL;
+        unsigned int REGISTRY_LINE = 0;
+    #endif
+    #define register_buffer(target)         util_register_buffer(target);
+    #define unregister_buffer(target)       util_unregister_buffer(target);
+    #define track_footprint(target)         util_track_footprint(target);
+    #define account_bytes(bytes)            util_account_bytes(bytes);
+#else
+    #define register_buffer(target)
+    #define unregister_buffer(target)
+    #define track_footprint(target)
+    #define account_bytes(bytes)
+#endif
+
 unsigned int util_get_size(buffer target)
 {
-    unsigned int i, size = 0;
-    for (i = 0; i < target->num_types; i++)
-        size += sizes[target->types[i]];
-    return size;
+    return target->offsets[target->num_types];
 }
 
 unsigned int util_get_size_until(buffer target, unsigned int num_fields)
 {
-    unsigned int i, size = 0;
-    for (i = 0; i < num_fields; i++)
-        size += sizes[target->types[i]];
-    return size;
+    return target->offsets[num_fields];
+}
+
+unsigned int* util_compute_offsets(unsigned int num_types, enum construct_types* types)
+{
+    unsigned int i, num_bits = 0, *offsets = malloc(sizeof(unsigned int) * (2 * num_types + 1));
+    offsets[0] = 0;
+    for (i = 0; i < num_types; i++)
+        offsets[i + 1] = offsets[i] + sizes[types[i]];
+    for (i = 0; i < num_types; i++)
+    {
+        offsets[num_types + 1 + i] = 0;
+        if (types[i] == BIT)
+        {
+            offsets[i] = offsets[num_types] + num_bits / 8;
+            offsets[num_types + 1 + i] = 1u << (num_bits % 8);
+            num_bits++;
+        }
+    }
+    offsets[num_types] += (num_bits + 7) / 8;
+    return offsets;
+}
+
+buffer util_create_buffer(unsigned int num_elements, unsigned int num_types, enum construct_types* types)
+{
+    buffer target;
+    target = malloc(sizeof(struct buffer));
+    target->num_types = num_types;
+    target->iterator = -1;
+    target->types = types;
+    target->offsets = util_compute_offsets(num_types,types);
+    target->parent = NULL;
+    target->references = NULL;
+    target->arena = NULL;
+    target->sorted_by = 0;
+    target->num_views = 0;
+    util_create_dictionaries(target);
+    memset(&target->stats,0,sizeof(struct construct_stats));
+    target->stride = util_get_size(target);
+    target->data_buffer = malloc(num_elements * target->stride);
+    target->num_elements = num_elements;
+    register_buffer(target);
+    return target;
+}
+
+buffer util_create_buffer_like(unsigned int num_elements, buffer src)
+{
+    buffer target = util_create_buffer(num_elements,src->num_types,util_copy_types(src));
+    util_share_dictionaries(target,src);
+    return target;
+}
+
+enum construct_types* util_copy_types(buffer target)
+{
+    enum construct_types* types = malloc(sizeof(enum construct_types) * target->num_types);
+    memcpy(types,target->types,sizeof(enum construct_types) * target->num_types);
+    return types;
+}
+
+void util_copy_elements(buffer dest, unsigned int destidx, buffer src, unsigned int srcidx, unsigned int num_elements)
+{
+    unsigned int i, size = util_get_size(src);
+    count_stat(dest,bytes_copied,size * num_elements);
+    if (dest->stride == size && src->stride == size)
+    {
+        util_memcpy(dest->data_buffer + size * destidx,src->data_buffer + size * srcidx,size * num_elements);
+        return;
+    }
+    for (i = 0; i < num_elements; i++)
+        memcpy(dest->data_buffer + dest->stride * (destidx + i),src->data_buffer + src->stride * (srcidx + i),size);
+}
+
+void util_zero_elements(buffer target, unsigned int index, unsigned int num_elements)
+{
+    unsigned int i, size = util_get_size(target);
+    count_stat(target,bytes_zeroed,size * num_elements);
+    if (target->stride == size)
+    {
+        util_memset(target->data_buffer + size * index,0,size * num_elements);
+        return;
+    }
+    for (i = 0; i < num_elements; i++)
+        memset(target->data_buffer + target->stride * (index + i),0,size);
+}
+
+void util_prepare_write(buffer target)
+{
+    if (target->sorted_by != 0)
+        target->sorted_by = 0;
+    while (target->parent != NULL)
+    {
+        #ifdef ERROR_CHECKING
+        error_if(target->parent->references != NULL && util_load_references(*target->parent->references) > 1,ERROR_SHARED_VIEW);
+        #endif
+        target = target->parent;
+        if (target->sorted_by != 0)
+            target->sorted_by = 0;
+    }
+    if (target->references == NULL)
+        return;
+
+    if (util_load_references(*target->references) > 1)
+    {
+        unsigned int size = target->stride * target->num_elements;
+        void* data = malloc(size);
+        util_memcpy(data,target->data_buffer,size);
+        count_stat(target,bytes_copied,size);
+        account_bytes(size);
+        /* Another copy may have given up the data buffer at the same time, leaving it to this one */
+        if (util_release_reference(*target->references) == 0)
+        {
+            free(target->data_buffer);
+            free(target->references);
+        }
+        target->data_buffer = data;
+    }
+    else
+        free(target->references);
+    target->references = NULL;
+    track_footprint(target);
+}
+
+void util_copy_fields(void* dest, unsigned int dest_stride, const unsigned int* dest_offsets, const void* src, unsigned int src_stride, const unsigned int* src_offsets, buffer layout, unsigned int num_elements)
+{
+    unsigned int i, j, num_fields = layout->num_types;
+    if (num_fields == 0)
+        return;
+    if (dest_offsets == NULL)
+        dest_offsets = layout->offsets;
+    if (src_offsets == NULL)
+        src_offsets = layout->offsets;
+
+    for (i = 0; i < num_elements; i++)
+        for (j = 0; j < num_fields; j++)
+        {
+            if (layout->types[j] == BIT)
+            {
+                unsigned int mask = layout->offsets[num_fields + 1 + j];
+                const unsigned char* from = (const unsigned char*)src + src_stride * i + src_offsets[j];
+                unsigned char* to = (unsigned char*)dest + dest_stride * i + dest_offsets[j];
+                unsigned int set = src_offsets == layout->offsets ? (*from & mask) != 0 : *from != 0;
+                if (dest_offsets != layout->offsets)
+                    *to = set;
+                else if (set)
+                    *to |= mask;
+                else
+                    *to &= ~mask;
+            }
+            else
+                memcpy((unsigned char*)dest + dest_stride * i + dest_offsets[j],(const unsigned char*)src + src_stride * i + src_offsets[j],sizes[layout->types[j]]);
+        }
 }
 
 void swap(void* src1, void* src2, unsigned int size)
@@ -114,6 +792,93 @@ void swap(void* src1, void* src2, unsigned int size)
     memcpy(src1, temp,size);
 }
 
+void util_get_footprint(buffer target, struct construct_footprint* footprint)
+{
+    footprint->file = NULL;
+    footprint->line = 0;
+    footprint->header_bytes = sizeof(struct buffer);
+    footprint->type_bytes = 0;
+    footprint->data_bytes = 0;
+    footprint->slack_bytes = 0;
+    if (target->parent == NULL)
+    {
+        footprint->type_bytes = sizeof(enum construct_types) * target->num_types + sizeof(unsigned int) * (2 * target->num_types + 1);
+        if (target->dictionaries != NULL)
+            footprint->type_bytes += sizeof(struct construct_dictionary*) * target->num_types;
+        footprint->data_bytes = (unsigned long)target->stride * target->num_elements;
+        if (target->references != NULL)
+            footprint->data_bytes /= util_load_references(*target->references);
+    }
+    footprint->peak_bytes = footprint->header_bytes + footprint->type_bytes + footprint->data_bytes + footprint->slack_bytes;
+}
+
+#ifdef CONSTRUCT_REGISTRY
+static void util_add_registry_bytes(long bytes)
+{
+    REGISTRY_BYTES += bytes;
+    if (REGISTRY_BYTES > REGISTRY_PEAK_BYTES)
+        REGISTRY_PEAK_BYTES = REGISTRY_BYTES;
+}
+
+void util_account_bytes(long bytes)
+{
+    util_lock_registry();
+    util_add_registry_bytes(bytes);
+    util_unlock_registry();
+}
+
+void util_track_footprint(buffer target)
+{
+    struct construct_footprint footprint;
+    util_get_footprint(target,&footprint);
+    if (footprint.peak_bytes > target->peak_bytes)
+        target->peak_bytes = footprint.peak_bytes;
+}
+
+void util_register_buffer(buffer target)
+{
+    target->registry_file = REGISTRY_FILE;
+    target->registry_line = REGISTRY_LINE;
+    REGISTRY_FILE = NULL;
+    REGISTRY_LINE = 0;
+
+    struct construct_footprint footprint;
+    util_get_footprint(target,&footprint);
+    target->peak_bytes = footprint.peak_bytes;
+
+    util_lock_registry();
+    target->registry_prev = NULL;
+    target->registry_next = REGISTRY;
+    if (REGISTRY != NULL)
+        REGISTRY->registry_prev = target;
+    REGISTRY = target;
+    REGISTRY_NUM_BUFFERS++;
+    util_add_registry_bytes(footprint.header_bytes + footprint.type_bytes + (target->references == NULL ? footprint.data_bytes : 0));
+    util_unlock_registry();
+}
+
+void util_unregister_buffer(buffer target)
+{
+    struct construct_footprint footprint;
+    util_get_footprint(target,&footprint);
+    if (target->parent == NULL && (target->references == NULL || util_load_references(*target->references) == 1))
+        footprint.data_bytes = (unsigned long)target->stride * target->num_elements;
+    else
+        footprint.data_bytes = 0;
+
+    util_lock_registry();
+    if (target->registry_prev != NULL)
+        target->registry_prev->registry_next = target->registry_next;
+    else
+        REGISTRY = target->registry_next;
+    if (target->registry_next != NULL)
+        target->registry_next->registry_prev = target->registry_prev;
+    REGISTRY_NUM_BUFFERS--;
+    util_add_registry_bytes(-(long)(footprint.header_bytes + footprint.type_bytes + footprint.data_bytes));
+    util_unlock_registry();
+}
+#endif
+
 void push_type(enum construct_types t)
 {
     if (CURRENT_TYPES == NULL)
@@ -156,7 +921,8 @@ void zero_buffer_out(buffer target)
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     #endif
-    memset(target->data_buffer,0,get_buffer_size(target));
+    util_prepare_write(target);
+    util_zero_elements(target,0,target->num_elements);
 }
 
 void zero_out()
@@ -164,28 +930,17 @@ void zero_out()
     #ifdef ERROR_CHECKING
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     #endif
-    memset(CURRENT_BUFFER->data_buffer,0,get_buffer_size(CURRENT_BUFFER));
+    util_prepare_write(CURRENT_BUFFER);
+    util_zero_elements(CURRENT_BUFFER,0,CURRENT_BUFFER->num_elements);
 }
 
 buffer init_buffer(unsigned int num_elements)
 {
-    buffer target;
-    target = malloc(sizeof(struct buffer));
-    target->num_types = CURRENT_NUM_TYPES;
-
-    target->iterator = -1;
-
     #ifdef ERROR_CHECKING
     error_if(CURRENT_TYPES == NULL,ERROR_NO_PUSHED_TYPES);
     #endif
 
-    target->types = CURRENT_TYPES;
-
-    
-    unsigned int size = util_get_size(target);
-
-    target->data_buffer = malloc(num_elements * size);
-    target->num_elements = num_elements;
+    buffer target = util_create_buffer(num_elements,CURRENT_NUM_TYPES,CURRENT_TYPES);
 
     CURRENT_TYPES = NULL;
     return target;
@@ -196,11 +951,28 @@ void deinit_buffer(buffer target)
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     #endif
+    if (target->arena != NULL)
+    {
+        util_free_arena(target);
+        return;
+    }
     if (target == CURRENT_BUFFER)
         CURRENT_BUFFER = NULL;
+    unregister_buffer(target);
 
-    free(target->data_buffer);
-    free(target->types);
+    if (target->parent == NULL)
+    {
+        if (target->references == NULL || util_release_reference(*target->references) == 0)
+        {
+            free(target->data_buffer);
+            free(target->references);
+        }
+        util_release_dictionaries(target);
+        free(target->types);
+        free(target->offsets);
+    }
+    else
+        util_release_reference(util_get_root_buffer(target)->num_views);
     free(target);
 }
 
@@ -209,6 +981,7 @@ void* get_data_buffer()
     #ifdef ERROR_CHECKING
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     #endif
+    util_prepare_write(CURRENT_BUFFER);
     return CURRENT_BUFFER->data_buffer;
 }
 
@@ -236,9 +1009,11 @@ void swap_at(unsigned int idx1, unsigned int idx2)
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     error_if(idx1 >= CURRENT_BUFFER->num_elements || idx2 >= CURRENT_BUFFER->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
     #endif
+    util_prepare_write(CURRENT_BUFFER);
     unsigned int size = util_get_size(CURRENT_BUFFER);
 
-    swap(CURRENT_BUFFER->data_buffer + size * idx1,CURRENT_BUFFER->data_buffer + size * idx2,size);
+    swap(CURRENT_BUFFER->data_buffer + CURRENT_BUFFER->stride * idx1,CURRENT_BUFFER->data_buffer + CURRENT_BUFFER->stride * idx2,size);
+    count_stat(CURRENT_BUFFER,swaps,1);
 }
 
 void replace_at(unsigned int index, buffer data)
@@ -247,20 +1022,25 @@ void replace_at(unsigned int index, buffer data)
     error_if(data == NULL,ERROR_INVALID_DATA);
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     #endif
-    unsigned int size = util_get_size(CURRENT_BUFFER);
-    memcpy(CURRENT_BUFFER->data_buffer + size * index,data->data_buffer,size);
+    util_prepare_write(CURRENT_BUFFER);
+    util_copy_elements(CURRENT_BUFFER,index,data,0,1);
 }
 
 void remove_at(unsigned int index)
 {
     #ifdef ERROR_CHECKING
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(CURRENT_BUFFER->parent != NULL,ERROR_RESIZED_VIEW);
+    error_if(CURRENT_BUFFER->arena != NULL,ERROR_ARENA_BUFFER);
     #endif
-    unsigned int i,size = util_get_size(CURRENT_BUFFER);
+    util_prepare_write(CURRENT_BUFFER);
+    unsigned int size = util_get_size(CURRENT_BUFFER);
+    account_bytes(-(long)size);
     CURRENT_BUFFER->num_elements--;
-    for (i = index; i < CURRENT_BUFFER->num_elements; i++)
-        memcpy(CURRENT_BUFFER->data_buffer + size * i,CURRENT_BUFFER->data_buffer + size * (i + 1), size);
+    memmove(CURRENT_BUFFER->data_buffer + size * index,CURRENT_BUFFER->data_buffer + size * (index + 1),size * (CURRENT_BUFFER->num_elements - index));
     CURRENT_BUFFER->data_buffer = realloc(CURRENT_BUFFER->data_buffer,CURRENT_BUFFER->num_elements * size);
+    count_stat(CURRENT_BUFFER,bytes_copied,size * (CURRENT_BUFFER->num_elements - index));
+    count_stat(CURRENT_BUFFER,reallocs,1);
     CURRENT_BUFFER->iterator--;
 }
 
@@ -268,11 +1048,21 @@ void resize(unsigned int num_elements)
 {
     #ifdef ERROR_CHECKING
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(CURRENT_BUFFER->parent != NULL,ERROR_RESIZED_VIEW);
+    error_if(CURRENT_BUFFER->arena != NULL,ERROR_ARENA_BUFFER);
     #endif
+    util_prepare_write(CURRENT_BUFFER);
     unsigned int size = util_get_size(CURRENT_BUFFER);
+    account_bytes(((long)num_elements - (long)CURRENT_BUFFER->num_elements) * (long)size);
     CURRENT_BUFFER->data_buffer = realloc(CURRENT_BUFFER->data_buffer,num_elements * size);
-    memset(CURRENT_BUFFER->data_buffer + size * CURRENT_BUFFER->num_elements,0,(num_elements - CURRENT_BUFFER->num_elements) * size);
+    count_stat(CURRENT_BUFFER,reallocs,1);
+    if (num_elements > CURRENT_BUFFER->num_elements)
+    {
+        util_memset(CURRENT_BUFFER->data_buffer + size * CURRENT_BUFFER->num_elements,0,(num_elements - CURRENT_BUFFER->num_elements) * size);
+        count_stat(CURRENT_BUFFER,bytes_zeroed,(num_elements - CURRENT_BUFFER->num_elements) * size);
+    }
     CURRENT_BUFFER->num_elements = num_elements;
+    track_footprint(CURRENT_BUFFER);
 }
 
 unsigned int get_element_size()
@@ -310,11 +1100,7 @@ unsigned int get_length()
 
 void* get_field(unsigned int field)
 {
-    unsigned int i,off = 0,size = util_get_size(CURRENT_BUFFER);
-    for (i = 0; i < field; i++)
-        off += sizes[CURRENT_BUFFER->types[i]];
-
-    return CURRENT_BUFFER->data_buffer + off + size * CURRENT_BUFFER->iterator;
+    return CURRENT_BUFFER->data_buffer + CURRENT_BUFFER->offsets[field] + CURRENT_BUFFER->stride * CURRENT_BUFFER->iterator;
 }
 
 
@@ -386,13 +1172,130 @@ void* get_fieldv(unsigned int field)
     return cast_to(void*)get_field(field);
 }
 
+signed char get_fieldi8(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(INT8 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    return cast_to(signed char)get_field(field);
+}
+
+short get_fieldi16(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(INT16 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    return cast_to(short)get_field(field);
+}
+
+unsigned short get_fieldui16(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(UINT16 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    return cast_to(unsigned short)get_field(field);
+}
+
+long long get_fieldi64(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(INT64 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    return cast_to(long long)get_field(field);
+}
+
+unsigned long long get_fieldui64(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(UINT64 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    return cast_to(unsigned long long)get_field(field);
+}
+
+double get_fieldd(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(DOUBLE != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    return cast_to(double)get_field(field);
+}
+
+float get_fieldh(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(HALF != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    return half_to_float(cast_to(unsigned short)get_field(field));
+}
+
+unsigned int get_fieldb(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return get_buffer_fieldb(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field);
+}
+
+const char* get_fields(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return get_buffer_fields(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field);
+}
+
+buffer get_fieldn(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return get_buffer_fieldn(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field);
+}
+
+const char* get_fieldp(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return get_buffer_fieldp(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field);
+}
+
 void set_field(unsigned int field, void* data)
 {
     #ifdef ERROR_CHECKING
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     error_if(data == NULL,ERROR_INVALID_DATA);
     #endif
-    memcpy(get_field(field),data,sizes[CURRENT_BUFFER->types[field]]);
+    util_prepare_write(CURRENT_BUFFER);
+    if (CURRENT_BUFFER->types[field] == BIT)
+        set_bit_field(get_field(field),CURRENT_BUFFER->offsets[CURRENT_BUFFER->num_types + 1 + field],*(unsigned char*)data);
+    else
+        memcpy(get_field(field),data,sizes[CURRENT_BUFFER->types[field]]);
 }
 
 void set_fieldui(unsigned int field, unsigned int data)
@@ -460,12 +1363,126 @@ void set_fieldv(unsigned int field, void* data)
     set_field(field,&data);
 }
 
+void set_fieldi8(unsigned int field, signed char data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(INT8 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    set_field(field,&data);
+}
+
+void set_fieldi16(unsigned int field, short data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(INT16 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    set_field(field,&data);
+}
+
+void set_fieldui16(unsigned int field, unsigned short data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(UINT16 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    set_field(field,&data);
+}
+
+void set_fieldi64(unsigned int field, long long data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(INT64 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    set_field(field,&data);
+}
+
+void set_fieldui64(unsigned int field, unsigned long long data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(UINT64 != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    set_field(field,&data);
+}
+
+void set_fieldd(unsigned int field, double data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(DOUBLE != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+
+    set_field(field,&data);
+}
+
+void set_fieldh(unsigned int field, float data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(field >= CURRENT_BUFFER->num_types,ERROR_INVALID_FIELD);
+    error_if(HALF != CURRENT_BUFFER->types[field],ERROR_INVALID_TYPE);
+    #endif
+    unsigned short bits = float_to_half(data);
+
+    set_field(field,&bits);
+}
+
+void set_fieldb(unsigned int field, unsigned int data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    set_buffer_fieldb(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,data);
+}
+
+void set_fields(unsigned int field, const char* data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    set_buffer_fields(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,data);
+}
+
+void set_fieldn(unsigned int field, buffer data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    set_buffer_fieldn(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,data);
+}
+
+void set_fieldp(unsigned int field, const char* data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    set_buffer_fieldp(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,data);
+}
+
 unsigned int get_element_data_offset(unsigned int index)
 {
     #ifdef ERROR_CHECKING
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     #endif
-    return util_get_size(CURRENT_BUFFER) * index;
+    return CURRENT_BUFFER->stride * index;
 }
 
 unsigned int get_buffer_element_data_offset(buffer target, unsigned int index)
@@ -473,7 +1490,7 @@ unsigned int get_buffer_element_data_offset(buffer target, unsigned int index)
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     #endif
-    return util_get_size(target) * index;
+    return target->stride * index;
 }
 
 void* get_buffer_data_buffer(buffer target)
@@ -481,6 +1498,7 @@ void* get_buffer_data_buffer(buffer target)
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     #endif
+    util_prepare_write(target);
     return target->data_buffer;
 }
 
@@ -490,9 +1508,11 @@ void swap_buffer_at(buffer target, unsigned int idx1, unsigned int idx2)
     error_if(target == NULL,ERROR_BAD_BUFFER);
     error_if(idx1 > target->num_elements || idx2 > target->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
     #endif
+    util_prepare_write(target);
     unsigned int size = util_get_size(target);
 
     swap(target->data_buffer + get_buffer_element_data_offset(target,idx1),target->data_buffer + get_buffer_element_data_offset(target,idx2),size);
+    count_stat(target,swaps,1);
 }
 
 void swap_buffer_at_buffer(buffer src, unsigned int idxsrc, buffer dest, unsigned int idxdest)
@@ -504,9 +1524,12 @@ void swap_buffer_at_buffer(buffer src, unsigned int idxsrc, buffer dest, unsigne
     error_if(util_get_size(dest) != util_get_size(src),ERROR_UNEQUAL_ELEMENT_SIZE);
     error_if(dest->num_elements < src->num_elements, ERROR_SMALL_DEST_BUFFER);
     #endif
+    util_prepare_write(src);
+    util_prepare_write(dest);
 
     unsigned int size = util_get_size(src);
-    swap(src->data_buffer + size * idxsrc,dest->data_buffer + size * idxdest,size);
+    swap(src->data_buffer + src->stride * idxsrc,dest->data_buffer + dest->stride * idxdest,size);
+    count_stat(dest,swaps,1);
 }
 
 void replace_buffer_at_buffer(buffer src, unsigned int idxsrc, buffer dest, unsigned int idxdest)
@@ -518,9 +1541,9 @@ void replace_buffer_at_buffer(buffer src, unsigned int idxsrc, buffer dest, unsi
     error_if(util_get_size(dest) != util_get_size(src),ERROR_UNEQUAL_ELEMENT_SIZE);
     error_if(dest->num_elements < src->num_elements, ERROR_SMALL_DEST_BUFFER);
     #endif
+    util_prepare_write(dest);
 
-    unsigned int size = util_get_size(src);
-    memcpy(dest->data_buffer + size * idxdest,src->data_buffer + size * idxsrc,size);
+    util_copy_elements(dest,idxdest,src,idxsrc,1);
 }
 
 void replace_buffer_at(buffer target, unsigned int index, buffer element)
@@ -528,31 +1551,46 @@ void replace_buffer_at(buffer target, unsigned int index, buffer element)
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     #endif
-    unsigned int size = util_get_size(target);
-    memcpy(target->data_buffer + size * index,element->data_buffer,size);
+    util_prepare_write(target);
+    util_copy_elements(target,index,element,0,1);
 }
 
 void remove_buffer_at(buffer target,unsigned int index)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(target->parent != NULL,ERROR_RESIZED_VIEW);
+    error_if(target->arena != NULL,ERROR_ARENA_BUFFER);
     #endif
-    unsigned int i,size = util_get_size(target);
+    util_prepare_write(target);
+    unsigned int size = util_get_size(target);
+    account_bytes(-(long)size);
     target->num_elements--;
-    for (i = index; i < target->num_elements; i++)
-        memcpy(target->data_buffer + size * i,target->data_buffer + size * (i + 1), size);
+    memmove(target->data_buffer + size * index,target->data_buffer + size * (index + 1),size * (target->num_elements - index));
     target->data_buffer = realloc(target->data_buffer,target->num_elements * size);
+    count_stat(target,bytes_copied,size * (target->num_elements - index));
+    count_stat(target,reallocs,1);
 }
 
 void resize_buffer(buffer target, unsigned int num_elements)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(target->parent != NULL,ERROR_RESIZED_VIEW);
+    error_if(target->arena != NULL,ERROR_ARENA_BUFFER);
     #endif
+    util_prepare_write(target);
     unsigned int size = util_get_size(target);
+    account_bytes(((long)num_elements - (long)target->num_elements) * (long)size);
     target->data_buffer = realloc(target->data_buffer,num_elements * size);
-    memset(target->data_buffer + size * target->num_elements,0,(num_elements - target->num_elements) * size);
+    count_stat(target,reallocs,1);
+    if (num_elements > target->num_elements)
+    {
+        util_memset(target->data_buffer + size * target->num_elements,0,(num_elements - target->num_elements) * size);
+        count_stat(target,bytes_zeroed,(num_elements - target->num_elements) * size);
+    }
     target->num_elements = num_elements;
+    track_footprint(target);
 }
 
 unsigned int get_buffer_element_size(buffer target)
@@ -593,11 +1631,7 @@ void* get_buffer_field(buffer target, unsigned int element, unsigned int field)
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     #endif
-    unsigned int i,off = 0,size = util_get_size(target);
-    for (i = 0; i < field; i++)
-        off += sizes[target->types[i]];
-
-    return target->data_buffer + off + size * element;
+    return target->data_buffer + target->offsets[field] + target->stride * element;
 }
 
 
@@ -667,1024 +1701,5286 @@ void* get_buffer_fieldv(buffer target, unsigned int element, unsigned int field)
     return cast_to(void*)get_buffer_field(target,element,field);
 }
 
-void set_buffer_field(buffer target, unsigned int element, unsigned int field, void* data)
+signed char get_buffer_fieldi8(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
-    error_if(element >= target->num_elements,ERROR_OUT_OF_BOUNDS_ELEMENT);
-    error_if(data == NULL,ERROR_INVALID_DATA);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(INT8 != target->types[field],ERROR_INVALID_TYPE);
     #endif
 
-    memcpy(get_buffer_field(target,element,field),data,sizes[target->types[field]]);
+    return cast_to(signed char)get_buffer_field(target,element,field);
 }
 
-void set_buffer_fieldui(buffer target, unsigned int element, unsigned int field, unsigned int data)
+short get_buffer_fieldi16(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     error_if(field >= target->num_types,ERROR_INVALID_FIELD);
-    error_if(UINT != target->types[field],ERROR_INVALID_TYPE);
+    error_if(INT16 != target->types[field],ERROR_INVALID_TYPE);
     #endif
 
-    set_buffer_field(target,element, field,&data);
+    return cast_to(short)get_buffer_field(target,element,field);
 }
 
-void set_buffer_fieldi(buffer target, unsigned int element, unsigned int field, int data)
+unsigned short get_buffer_fieldui16(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     error_if(field >= target->num_types,ERROR_INVALID_FIELD);
-    error_if(INT != target->types[field],ERROR_INVALID_TYPE);
+    error_if(UINT16 != target->types[field],ERROR_INVALID_TYPE);
     #endif
 
-    set_buffer_field(target,element, field,&data);
+    return cast_to(unsigned short)get_buffer_field(target,element,field);
 }
 
-void set_buffer_fieldf(buffer target, unsigned int element, unsigned int field, float data)
+long long get_buffer_fieldi64(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     error_if(field >= target->num_types,ERROR_INVALID_FIELD);
-    error_if(FLOAT != target->types[field],ERROR_INVALID_TYPE);
+    error_if(INT64 != target->types[field],ERROR_INVALID_TYPE);
     #endif
 
-    set_buffer_field(target,element,field,&data);
+    return cast_to(long long)get_buffer_field(target,element,field);
 }
 
-void set_buffer_fieldc(buffer target, unsigned int element, unsigned int field, char data)
+unsigned long long get_buffer_fieldui64(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     error_if(field >= target->num_types,ERROR_INVALID_FIELD);
-    error_if(CHAR != target->types[field],ERROR_INVALID_TYPE);
+    error_if(UINT64 != target->types[field],ERROR_INVALID_TYPE);
     #endif
 
-    set_buffer_field(target,element, field,&data);
+    return cast_to(unsigned long long)get_buffer_field(target,element,field);
 }
 
-void set_buffer_fielduc(buffer target, unsigned int element, unsigned int field, unsigned char data)
+double get_buffer_fieldd(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     error_if(field >= target->num_types,ERROR_INVALID_FIELD);
-    error_if(UCHAR != target->types[field],ERROR_INVALID_TYPE);
+    error_if(DOUBLE != target->types[field],ERROR_INVALID_TYPE);
     #endif
 
-    set_buffer_field(target,element, field,&data);
+    return cast_to(double)get_buffer_field(target,element,field);
 }
 
-void set_buffer_fieldv(buffer target, unsigned int element, unsigned int field, void* data)
+float get_buffer_fieldh(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
     error_if(field >= target->num_types,ERROR_INVALID_FIELD);
-    error_if(VOID != target->types[field],ERROR_INVALID_TYPE);
+    error_if(HALF != target->types[field],ERROR_INVALID_TYPE);
     #endif
 
-    set_buffer_field(target,element, field,&data);
+    return half_to_float(cast_to(unsigned short)get_buffer_field(target,element,field));
 }
 
-void repush_buffer_types(buffer target)
+unsigned int get_buffer_fieldb(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(BIT != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int i;
-    for (i = 0; i < target->num_types; i++)
-        push_type(target->types[i]);
+
+    return (cast_to(unsigned char)get_buffer_field(target,element,field) & target->offsets[target->num_types + 1 + field]) != 0;
 }
 
-void repush_types()
+const char* get_buffer_fields(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(STR16 != target->types[field] && STR32 != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int i;
-    for (i = 0; i < CURRENT_BUFFER->num_types; i++)
-        push_type(CURRENT_BUFFER->types[i]);
-}
-
-buffer create_single_buffer_element(buffer target)
-{
-    buffer element;
-    element = malloc(sizeof(struct buffer));
-    element->num_types = target->num_types;
-    element->iterator = -1;
-    element->types = malloc(sizeof(enum construct_types) * target->num_types);
-    memcpy(element->types,target->types,sizeof(enum construct_types) * target->num_types);
-    unsigned int size = util_get_size(target);
-    element->data_buffer = malloc(size);
-    element->num_elements = 1;
 
-    return element;
+    return (const char*)get_buffer_field(target,element,field);
 }
 
-buffer create_single_element()
+buffer get_buffer_fieldn(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(NESTED != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    buffer element;
-    element = malloc(sizeof(struct buffer));
-    element->num_types = CURRENT_BUFFER->num_types;
-    element->iterator = -1;
-    element->types = malloc(sizeof(enum construct_types) * CURRENT_BUFFER->num_types);
-    memcpy(element->types,CURRENT_BUFFER->types,sizeof(enum construct_types) * CURRENT_BUFFER->num_types);
-    unsigned int size = util_get_size(CURRENT_BUFFER);
-    element->data_buffer = malloc(size);
-    element->num_elements = 1;
 
-    return element;
+    buffer child;
+    memcpy(&child,get_buffer_field(target,element,field),sizeof(buffer));
+    return child;
 }
 
-void copy_to_buffer(buffer dest)
+const char* get_buffer_fieldp(buffer target, unsigned int element, unsigned int field)
 {
-
-    #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
-    error_if(get_buffer_element_size(dest) != get_buffer_element_size(CURRENT_BUFFER),ERROR_UNEQUAL_ELEMENT_SIZE);
-    error_if(dest->num_elements < CURRENT_BUFFER->num_elements, ERROR_SMALL_DEST_BUFFER);
-    #endif
-    memcpy(dest->data_buffer,CURRENT_BUFFER->data_buffer,dest->num_elements * get_buffer_element_size(dest));
+    return get_interned_string(get_buffer_string_id(target,element,field));
 }
 
-void copy_from_buffer(buffer src)
+unsigned int get_buffer_string_id(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
-    error_if(get_buffer_element_size(CURRENT_BUFFER) != get_buffer_element_size(src),ERROR_UNEQUAL_ELEMENT_SIZE);
-    error_if(CURRENT_BUFFER->num_elements < src->num_elements, ERROR_SMALL_DEST_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(STRING != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    memcpy(CURRENT_BUFFER->data_buffer,src->data_buffer,CURRENT_BUFFER->num_elements * get_buffer_element_size(CURRENT_BUFFER));
+
+    return cast_to(unsigned int)get_buffer_field(target,element,field);
 }
 
-void copy_buffer_to_buffer(buffer src,buffer dest)
+void set_buffer_field(buffer target, unsigned int element, unsigned int field, void* data)
 {
     #ifdef ERROR_CHECKING
-    error_if(src == NULL,ERROR_BAD_BUFFER);
-    error_if(dest == NULL,ERROR_BAD_BUFFER);
-    error_if(get_buffer_element_size(dest) != get_buffer_element_size(src),ERROR_UNEQUAL_ELEMENT_SIZE);
-    error_if(dest->num_elements < src->num_elements, ERROR_SMALL_DEST_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(element >= target->num_elements,ERROR_OUT_OF_BOUNDS_ELEMENT);
+    error_if(data == NULL,ERROR_INVALID_DATA);
     #endif
-    memcpy(dest->data_buffer,src->data_buffer,dest->num_elements * get_buffer_element_size(dest));
+    util_prepare_write(target);
+
+    if (target->types[field] == BIT)
+        set_bit_field(get_buffer_field(target,element,field),target->offsets[target->num_types + 1 + field],*(unsigned char*)data);
+    else
+        memcpy(get_buffer_field(target,element,field),data,sizes[target->types[field]]);
 }
 
-buffer copy_buffer(buffer src)
+void set_buffer_fieldui(buffer target, unsigned int element, unsigned int field, unsigned int data)
 {
-    buffer copy = malloc(sizeof(struct buffer));
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(UINT != target->types[field],ERROR_INVALID_TYPE);
+    #endif
 
-    copy->iterator = src->iterator;
+    set_buffer_field(target,element, field,&data);
+}
 
-    unsigned int i, size = util_get_size(src);
-    copy->num_types = src->num_types;
-    copy->types = malloc(sizeof(enum construct_types) * copy->num_types);
-    for (i = 0; i < src->num_types; i++)
-        copy->types[i] = src->types[i];
+void set_buffer_fieldi(buffer target, unsigned int element, unsigned int field, int data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(INT != target->types[field],ERROR_INVALID_TYPE);
+    #endif
 
-    copy->data_buffer = malloc(src->num_elements * size);
-    copy->num_elements = src->num_elements;
+    set_buffer_field(target,element, field,&data);
+}
 
-    copy_buffer_to_buffer(src,copy);
+void set_buffer_fieldf(buffer target, unsigned int element, unsigned int field, float data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(FLOAT != target->types[field],ERROR_INVALID_TYPE);
+    #endif
 
-    return copy;
+    set_buffer_field(target,element,field,&data);
 }
 
+void set_buffer_fieldc(buffer target, unsigned int element, unsigned int field, char data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(CHAR != target->types[field],ERROR_INVALID_TYPE);
+    #endif
 
+    set_buffer_field(target,element, field,&data);
+}
 
-void append_at(buffer src)
+void set_buffer_fielduc(buffer target, unsigned int element, unsigned int field, unsigned char data)
 {
     #ifdef ERROR_CHECKING
-    error_if(src == NULL,ERROR_BAD_BUFFER);
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(UCHAR != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int size = util_get_size(CURRENT_BUFFER),old_num_element = CURRENT_BUFFER->num_elements;
-    resize_buffer(CURRENT_BUFFER,CURRENT_BUFFER->num_elements + src->num_elements);
-    memcpy(CURRENT_BUFFER->data_buffer + size * old_num_element,src->data_buffer,util_get_size(src) * src->num_elements);
+
+    set_buffer_field(target,element, field,&data);
 }
 
-void append_to(buffer dest)
+void set_buffer_fieldv(buffer target, unsigned int element, unsigned int field, void* data)
 {
     #ifdef ERROR_CHECKING
-    error_if(dest == NULL,ERROR_BAD_BUFFER);
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(VOID != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int size = util_get_size(dest),old_num_element = dest->num_elements;
-    resize_buffer(dest,dest->num_elements + CURRENT_BUFFER->num_elements);
-    memcpy(dest->data_buffer + size * old_num_element,CURRENT_BUFFER->data_buffer,util_get_size(CURRENT_BUFFER) * CURRENT_BUFFER->num_elements);
+
+    set_buffer_field(target,element, field,&data);
 }
 
-void append_buffer_at(buffer src, buffer dest)
+void set_buffer_fieldi8(buffer target, unsigned int element, unsigned int field, signed char data)
 {
     #ifdef ERROR_CHECKING
-    error_if(src == NULL,ERROR_BAD_BUFFER);
-    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(INT8 != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int size = util_get_size(dest),old_num_element = dest->num_elements;
-    resize_buffer(dest,dest->num_elements + src->num_elements);
-    memcpy(dest->data_buffer + size * old_num_element,src->data_buffer,util_get_size(src) * src->num_elements);
+
+    set_buffer_field(target,element,field,&data);
 }
 
-void append_element_at(buffer src, unsigned int index)
+void set_buffer_fieldi16(buffer target, unsigned int element, unsigned int field, short data)
 {
     #ifdef ERROR_CHECKING
-    error_if(src == NULL,ERROR_BAD_BUFFER);
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(INT16 != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int size = util_get_size(CURRENT_BUFFER),old_num_element = CURRENT_BUFFER->num_elements;
-    resize_buffer(CURRENT_BUFFER,CURRENT_BUFFER->num_elements + src->num_elements);
-    memcpy(CURRENT_BUFFER->data_buffer + size * old_num_element,src->data_buffer + get_buffer_element_data_offset(src,index),util_get_size(src));
+
+    set_buffer_field(target,element,field,&data);
 }
 
-void append_element_to(buffer dest, unsigned int index)
+void set_buffer_fieldui16(buffer target, unsigned int element, unsigned int field, unsigned short data)
 {
     #ifdef ERROR_CHECKING
-    error_if(dest == NULL,ERROR_BAD_BUFFER);
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(UINT16 != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int size = util_get_size(dest);
-    resize_buffer(dest,dest->num_elements + 1);
-    memcpy(dest->data_buffer + size * (dest->num_elements - 1),CURRENT_BUFFER->data_buffer + size * index,size);
+
+    set_buffer_field(target,element,field,&data);
 }
 
-void append_buffer_element_at(buffer src, unsigned int index, buffer dest)
+void set_buffer_fieldi64(buffer target, unsigned int element, unsigned int field, long long data)
 {
     #ifdef ERROR_CHECKING
-    error_if(dest == NULL,ERROR_BAD_BUFFER);
-    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(INT64 != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    unsigned int size = util_get_size(dest);
-    resize_buffer(dest,dest->num_elements + 1);
-    memcpy(dest->data_buffer + size * (dest->num_elements - 1),src->data_buffer + size * index,size);
+
+    set_buffer_field(target,element,field,&data);
 }
 
-void flush_types()
+void set_buffer_fieldui64(buffer target, unsigned int element, unsigned int field, unsigned long long data)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_TYPES == NULL,ERROR_NO_PUSHED_TYPES);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(UINT64 != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    free(CURRENT_TYPES);
-    CURRENT_TYPES = NULL;
-    CURRENT_NUM_TYPES = 0;
+
+    set_buffer_field(target,element,field,&data);
 }
 
-void pop_types(unsigned int num_types)
+void set_buffer_fieldd(buffer target, unsigned int element, unsigned int field, double data)
 {
     #ifdef ERROR_CHECKING
-    error_if(num_types < num_types,ERROR_INVALID_NUM_TYPES);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(DOUBLE != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    CURRENT_NUM_TYPES -= num_types;
-    CURRENT_TYPES = realloc(CURRENT_TYPES,CURRENT_NUM_TYPES * sizeof(enum construct_types));
+
+    set_buffer_field(target,element,field,&data);
 }
 
-void* dump_buffer_binary(buffer target, unsigned int* size)
+void set_buffer_fieldh(buffer target, unsigned int element, unsigned int field, float data)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(HALF != target->types[field],ERROR_INVALID_TYPE);
     #endif
+    unsigned short bits = float_to_half(data);
 
-    void* bin_data;
-
-    if (size == NULL)
-    {
-        bin_data = malloc(util_get_size(target) * target->num_elements); 
-        memcpy(bin_data,target->data_buffer,util_get_size(target) * target->num_elements);
-    }
-    else
-    {
-        *size = util_get_size(target) * target->num_elements;
-        bin_data = malloc(*size); 
-        memcpy(bin_data,target->data_buffer,*size);
-    }
-    
-    return bin_data;
+    set_buffer_field(target,element,field,&bits);
 }
 
-void load_buffer_binary(buffer target, void* bin_data, unsigned int size)
+void set_buffer_fieldb(buffer target, unsigned int element, unsigned int field, unsigned int data)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
-    error_if(bin_data == NULL,ERROR_INVALID_DATA);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(BIT != target->types[field],ERROR_INVALID_TYPE);
     #endif
-    if (util_get_size(target) * target->num_elements == size)
-    {
-        memcpy(target->data_buffer,bin_data,size);
-    }
-    else
-    {   
-        resize_buffer(target,size / util_get_size(target));
-        memcpy(target->data_buffer,bin_data,size);
-    }
+    util_prepare_write(target);
+
+    set_bit_field(get_buffer_field(target,element,field),target->offsets[target->num_types + 1 + field],data);
 }
 
-void* dump_binary(unsigned int* size)
+void set_buffer_fields(buffer target, unsigned int element, unsigned int field, const char* data)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(data == NULL,ERROR_INVALID_DATA);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(STR16 != target->types[field] && STR32 != target->types[field],ERROR_INVALID_TYPE);
+    error_if(strlen(data) >= sizes[target->types[field]],ERROR_LONG_STRING);
     #endif
+    util_prepare_write(target);
 
-    void* bin_data;
+    set_string_field(get_buffer_field(target,element,field),sizes[target->types[field]],data);
+}
 
-    if (size == NULL)
-    {
-        bin_data = malloc(util_get_size(CURRENT_BUFFER) * CURRENT_BUFFER->num_elements); 
-        memcpy(bin_data,CURRENT_BUFFER->data_buffer,util_get_size(CURRENT_BUFFER) * CURRENT_BUFFER->num_elements);
-    }
-    else
-    {
-        *size = util_get_size(CURRENT_BUFFER) * CURRENT_BUFFER->num_elements;
-        bin_data = malloc(*size); 
-        memcpy(bin_data,CURRENT_BUFFER->data_buffer,*size);
-    }
+void set_buffer_fieldn(buffer target, unsigned int element, unsigned int field, buffer data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(NESTED != target->types[field],ERROR_INVALID_TYPE);
+    error_if(data == target,ERROR_INVALID_DATA);
+    #endif
 
-    return bin_data;
+    set_buffer_field(target,element,field,&data);
 }
 
-void load_binary(void* bin_data, unsigned int size)
+void set_buffer_fieldp(buffer target, unsigned int element, unsigned int field, const char* data)
+{
+    set_buffer_string_id(target,element,field,intern_string(data));
+}
+
+void set_buffer_string_id(buffer target, unsigned int element, unsigned int field, unsigned int id)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
-    error_if(bin_data == NULL,ERROR_INVALID_DATA);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(STRING != target->types[field],ERROR_INVALID_TYPE);
+    error_if(id >= get_num_interned_strings(),ERROR_OUT_OF_BOUNDS_INDEX);
     #endif
-    if (util_get_size(CURRENT_BUFFER) * CURRENT_BUFFER->num_elements == size)
-    {
-        memcpy(CURRENT_BUFFER->data_buffer,bin_data,size);
-    }
-    else
-    {   
-        resize_buffer(CURRENT_BUFFER,size / util_get_size(CURRENT_BUFFER));
-        memcpy(CURRENT_BUFFER->data_buffer,bin_data,size);
-    }
+    util_prepare_write(target);
+
+    cast_to(unsigned int)get_buffer_field(target,element,field) = id;
 }
 
-buffer get_current_buffer()
+void set_buffer_element(buffer target, unsigned int element, const void* data)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(element >= target->num_elements,ERROR_OUT_OF_BOUNDS_ELEMENT);
+    error_if(data == NULL,ERROR_INVALID_DATA);
     #endif
+    util_prepare_write(target);
+    memcpy(target->data_buffer + target->stride * element,data,util_get_size(target));
+    count_stat(target,bytes_copied,util_get_size(target));
+}
 
-    return CURRENT_BUFFER;
+void get_buffer_element(buffer target, unsigned int element, void* data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(element >= target->num_elements,ERROR_OUT_OF_BOUNDS_ELEMENT);
+    error_if(data == NULL,ERROR_INVALID_DATA);
+    #endif
+    memcpy(data,target->data_buffer + target->stride * element,util_get_size(target));
 }
 
-void reverse()
+void set_element(const void* data)
 {
     #ifdef ERROR_CHECKING
     error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     #endif
+    set_buffer_element(CURRENT_BUFFER,CURRENT_BUFFER->iterator,data);
+}
 
-    unsigned int i, num_elements = CURRENT_BUFFER->num_elements;
-
-    for (i = 0; i < num_elements; i++)
-        swap_buffer_at(CURRENT_BUFFER,num_elements - i - 1, i);
+void get_element(void* data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    get_buffer_element(CURRENT_BUFFER,CURRENT_BUFFER->iterator,data);
 }
 
-void reverse_buffer(buffer target)
+void import_buffer_elements(buffer target, unsigned int index, const void* src, unsigned int num_elements, unsigned int src_size, const unsigned int* offsets)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(src == NULL,ERROR_INVALID_DATA);
+    error_if(index > target->num_elements,ERROR_OUT_OF_BOUNDS_ELEMENT);
     #endif
+    if (index + num_elements > target->num_elements)
+        resize_buffer(target,index + num_elements);
+    util_prepare_write(target);
 
-    unsigned int i, num_elements = target->num_elements;
-    for (i = 0; i < num_elements; i++)
-        swap_buffer_at(target,num_elements - i - 1, i);
+    util_copy_fields(target->data_buffer + target->stride * index,target->stride,NULL,src,src_size,offsets,target,num_elements);
+    count_stat(target,bytes_copied,util_get_size(target) * num_elements);
 }
 
-buffer recreate()
+void export_buffer_elements(buffer target, unsigned int index, void* dest, unsigned int num_elements, unsigned int dest_size, const unsigned int* offsets)
 {
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(dest == NULL,ERROR_INVALID_DATA);
+    error_if(index + num_elements > target->num_elements,ERROR_OUT_OF_BOUNDS_ELEMENT);
     #endif
 
-    buffer recreation;
-    recreation = malloc(sizeof(struct buffer));
-    recreation->num_types = CURRENT_BUFFER->num_types;
-    recreation->iterator = -1;
-    recreation->types = malloc(sizeof(enum construct_types) * CURRENT_BUFFER->num_types);
-    memcpy(recreation->types,CURRENT_BUFFER->types,sizeof(enum construct_types) * CURRENT_BUFFER->num_types);
-    recreation->num_elements = 0;
-    recreation->data_buffer = malloc(0);
+    util_copy_fields(dest,dest_size,offsets,target->data_buffer + target->stride * index,target->stride,NULL,target,num_elements);
+}
+
+#define CONSTRUCT_CONVERT_CHUNK 256
 
-    return recreation;
+unsigned int util_is_encoded_type(enum construct_types type)
+{
+    return type == DICT8 || type == DICT16;
 }
 
+unsigned int util_encode(struct construct_dictionary* dictionary, long long value);
 
-buffer recreate_buffer(buffer target)
+void util_create_dictionaries(buffer target)
 {
-    #ifdef ERROR_CHECKING
-    error_if(target == NULL,ERROR_BAD_BUFFER);
-    #endif
+    unsigned int i;
+    target->dictionaries = NULL;
+    for (i = 0; i < target->num_types; i++)
+    {
+        if (!util_is_encoded_type(target->types[i]))
+            continue;
+        if (target->dictionaries == NULL)
+        {
+            target->dictionaries = malloc(sizeof(struct construct_dictionary*) * target->num_types);
+            memset(target->dictionaries,0,sizeof(struct construct_dictionary*) * target->num_types);
+        }
+        struct construct_dictionary* dictionary = malloc(sizeof(struct construct_dictionary));
+        dictionary->references = 1;
+        dictionary->num_values = 0;
+        dictionary->capacity = 0;
+        dictionary->table_size = 0;
+        dictionary->max_values = target->types[i] == DICT8 ? 1u << 8 : 1u << 16;
+        dictionary->values = NULL;
+        dictionary->table = NULL;
+        /* Code 0 stands for 0, so zeroed and freshly resized elements read as 0 */
+        util_encode(dictionary,0);
+        target->dictionaries[i] = dictionary;
+    }
+}
 
-    buffer recreation;
-    recreation = malloc(sizeof(struct buffer));
-    recreation->num_types = target->num_types;
-    recreation->iterator = -1;
-    recreation->types = malloc(sizeof(enum construct_types) * target->num_types);
-    memcpy(recreation->types,target->types,sizeof(enum construct_types) * target->num_types);
-    recreation->num_elements = 0;
-    recreation->data_buffer = malloc(0);
+void util_release_dictionary(struct construct_dictionary* dictionary)
+{
+    if (dictionary == NULL || --dictionary->references != 0)
+        return;
+    free(dictionary->values);
+    free(dictionary->table);
+    free(dictionary);
+}
 
-    return recreation;
+void util_release_dictionaries(buffer target)
+{
+    unsigned int i;
+    if (target->dictionaries == NULL)
+        return;
+    for (i = 0; i < target->num_types; i++)
+        util_release_dictionary(target->dictionaries[i]);
+    free(target->dictionaries);
+    target->dictionaries = NULL;
 }
 
-void sort_by_field(unsigned int more,unsigned int field, enum construct_types type)
+void util_share_dictionaries(buffer dest, buffer src)
 {
-    #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
-    #endif
+    unsigned int i;
+    util_release_dictionaries(dest);
+    if (src->dictionaries == NULL)
+        return;
+    dest->dictionaries = malloc(sizeof(struct construct_dictionary*) * dest->num_types);
+    for (i = 0; i < dest->num_types; i++)
+    {
+        dest->dictionaries[i] = src->dictionaries[i];
+        if (dest->dictionaries[i] != NULL)
+            dest->dictionaries[i]->references++;
+    }
+}
 
-    int step,size = get_buffer_length(CURRENT_BUFFER);
-    for (step = 0; step < size - 1; ++step)
+void util_unshare_dictionaries(buffer target)
+{
+    unsigned int i;
+    if (target->dictionaries == NULL)
+        return;
+    for (i = 0; i < target->num_types; i++)
     {
-        int i,swapped = 0;
-        for (i = 0; i < size - step - 1; ++i)
+        struct construct_dictionary* shared = target->dictionaries[i];
+        if (shared == NULL)
+            continue;
+        struct construct_dictionary* dictionary = malloc(sizeof(struct construct_dictionary));
+        *dictionary = *shared;
+        dictionary->references = 1;
+        if (shared->capacity != 0)
         {
-            int condition = 0;
+            dictionary->values = malloc(sizeof(long long) * shared->capacity);
+            dictionary->table = malloc(sizeof(unsigned int) * shared->table_size);
+            memcpy(dictionary->values,shared->values,sizeof(long long) * shared->num_values);
+            memcpy(dictionary->table,shared->table,sizeof(unsigned int) * shared->table_size);
+        }
+        util_release_dictionary(shared);
+        target->dictionaries[i] = dictionary;
+    }
+}
 
-            if (more)
-            {
-                switch(type)
-                {
-                    case UINT:
-                    condition = get_buffer_fieldui(CURRENT_BUFFER,i,field) > get_buffer_fieldui(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case INT:
-                    condition = get_buffer_fieldi(CURRENT_BUFFER,i,field) > get_buffer_fieldi(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case CHAR:
-                    condition = get_buffer_fieldc(CURRENT_BUFFER,i,field) > get_buffer_fieldc(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case UCHAR:
-                    condition = get_buffer_fielduc(CURRENT_BUFFER,i,field) > get_buffer_fielduc(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case FLOAT:
-                    condition = get_buffer_fieldf(CURRENT_BUFFER,i,field) > get_buffer_fieldf(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case VOID:
-                    condition = get_buffer_fieldv(CURRENT_BUFFER,i,field) > get_buffer_fieldv(CURRENT_BUFFER,i+1,field);
-                    break;
-                    default:
-                    #ifdef ERROR_CHECKING
-                    error_if(0,ERROR_INVALID_TYPE);
-                    #endif
-                    break;
-                }
-            }
-            else
-            {
-                switch(type)
-                {
-                    case UINT:
-                    condition = get_buffer_fieldui(CURRENT_BUFFER,i,field) < get_buffer_fieldui(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case INT:
-                    condition = get_buffer_fieldi(CURRENT_BUFFER,i,field) < get_buffer_fieldi(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case CHAR:
-                    condition = get_buffer_fieldc(CURRENT_BUFFER,i,field) < get_buffer_fieldc(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case UCHAR:
-                    condition = get_buffer_fielduc(CURRENT_BUFFER,i,field) < get_buffer_fielduc(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case FLOAT:
-                    condition = get_buffer_fieldf(CURRENT_BUFFER,i,field) < get_buffer_fieldf(CURRENT_BUFFER,i+1,field);
-                    break;
-                    case VOID:
-                    condition = get_buffer_fieldv(CURRENT_BUFFER,i,field) < get_buffer_fieldv(CURRENT_BUFFER,i+1,field);
-                    break;
-                    default:
-                    #ifdef ERROR_CHECKING
-                    error_if(0,ERROR_INVALID_TYPE);
-                    #endif
-                    break;
-                }
-            }
-
-            if (condition)
-            {
-                swap_buffer_at(CURRENT_BUFFER,i,i+1);
-                swapped = 1;
-            }
-        }
-        if (swapped == 0)
-        {
-            break;
-        }
-    }
+static unsigned int util_dictionary_hash(long long value)
+{
+    unsigned long long hash = (unsigned long long)value * 0x9e3779b97f4a7c15ull;
+    return (unsigned int)(hash >> 32);
 }
 
-void sort_buffer_by_field(buffer target,unsigned int more,unsigned int field,enum construct_types type)
+static unsigned int* util_dictionary_slot(struct construct_dictionary* dictionary, long long value)
 {
-    #ifdef ERROR_CHECKING
-    error_if(target == NULL,ERROR_BAD_BUFFER);
-    #endif
-
-    int step,size = get_buffer_length(target);
-    for (step = 0; step < size - 1; ++step)
-    {
-        int i,swapped = 0;
-        for (i = 0; i < size - step - 1; ++i)
-        {
-            int condition = 0;
-
-            if (more)
-            {
-                switch(type)
-                {
-                    case UINT:
-                    condition = get_buffer_fieldui(target,i,field) > get_buffer_fieldui(target,i+1,field);
-                    break;
-                    case INT:
-                    condition = get_buffer_fieldi(target,i,field) > get_buffer_fieldi(target,i+1,field);
-                    break;
-                    case CHAR:
-                    condition = get_buffer_fieldc(target,i,field) > get_buffer_fieldc(target,i+1,field);
-                    break;
-                    case UCHAR:
-                    condition = get_buffer_fielduc(target,i,field) > get_buffer_fielduc(target,i+1,field);
-                    break;
-                    case FLOAT:
-                    condition = get_buffer_fieldf(target,i,field) > get_buffer_fieldf(target,i+1,field);
-                    break;
-                    case VOID:
-                    condition = get_buffer_fieldv(target,i,field) > get_buffer_fieldv(target,i+1,field);
-                    break;
-                    default:
-                    #ifdef ERROR_CHECKING
-                    error_if(0,ERROR_INVALID_TYPE);
-                    #endif
-                    break;
-                }
-            }
-            else
-            {
-                switch(type)
-                {
-                    case UINT:
-                    condition = get_buffer_fieldui(target,i,field) < get_buffer_fieldui(target,i+1,field);
-                    break;
-                    case INT:
-                    condition = get_buffer_fieldi(target,i,field) < get_buffer_fieldi(target,i+1,field);
-                    break;
-                    case CHAR:
-                    condition = get_buffer_fieldc(target,i,field) < get_buffer_fieldc(target,i+1,field);
-                    break;
-                    case UCHAR:
-                    condition = get_buffer_fielduc(target,i,field) < get_buffer_fielduc(target,i+1,field);
-                    break;
-                    case FLOAT:
-                    condition = get_buffer_fieldf(target,i,field) < get_buffer_fieldf(target,i+1,field);
-                    break;
-                    case VOID:
-                    condition = get_buffer_fieldv(target,i,field) < get_buffer_fieldv(target,i+1,field);
-                    break;
-                    default:
-                    #ifdef ERROR_CHECKING
-                    error_if(0,ERROR_INVALID_TYPE);
-                    #endif
-                    break;
-                }
-            }
-
-            if (condition)
-            {
-                swap_buffer_at(target,i,i+1);
-                swapped = 1;
-            }
-        }
-        if (swapped == 0)
-        {
-            break;
-        }
-    }
+    unsigned int slot = util_dictionary_hash(value) & (dictionary->table_size - 1);
+    while (dictionary->table[slot] != 0 && dictionary->values[dictionary->table[slot] - 1] != value)
+        slot = (slot + 1) & (dictionary->table_size - 1);
+    return dictionary->table + slot;
 }
 
-buffer copy_partial(unsigned int startidx, unsigned int endidx)
+static void util_grow_dictionary(struct construct_dictionary* dictionary)
 {
-    #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
-    error_if(startidx > endidx,ERROR_INVALID_INDEX);
-    error_if(endidx >= get_buffer_length(CURRENT_BUFFER),ERROR_OUT_OF_BOUNDS_INDEX);
-    #endif
-
-    buffer copy = malloc(sizeof(struct buffer));
-    copy->iterator = CURRENT_BUFFER->iterator;
+    unsigned int i;
+    dictionary->capacity = dictionary->capacity == 0 ? 16 : dictionary->capacity * 2;
+    dictionary->values = realloc(dictionary->values,sizeof(long long) * dictionary->capacity);
+    free(dictionary->table);
+    dictionary->table_size = dictionary->capacity * 2;
+    dictionary->table = malloc(sizeof(unsigned int) * dictionary->table_size);
+    memset(dictionary->table,0,sizeof(unsigned int) * dictionary->table_size);
+    for (i = 0; i < dictionary->num_values; i++)
+        *util_dictionary_slot(dictionary,dictionary->values[i]) = i + 1;
+}
 
-    unsigned int i, size = util_get_size(CURRENT_BUFFER);
-    copy->num_types = CURRENT_BUFFER->num_types;
-    copy->types = malloc(sizeof(enum construct_types) * copy->num_types);
-    for (i = 0; i < CURRENT_BUFFER->num_types; i++)
-        copy->types[i] = CURRENT_BUFFER->types[i];
+unsigned int util_find_code(struct construct_dictionary* dictionary, long long value)
+{
+    if (dictionary->num_values == 0)
+        return -1;
+    return *util_dictionary_slot(dictionary,value) - 1;
+}
 
-    copy->data_buffer = malloc((endidx - startidx) * size);
-    copy->num_elements = endidx - startidx;
+unsigned int util_encode(struct construct_dictionary* dictionary, long long value)
+{
+    unsigned int code = util_find_code(dictionary,value);
+    if (code != (unsigned int)-1)
+        return code;
+    /* Always checked, since the codes of the values that don't fit would silently wrap around */
+    error_if(dictionary->num_values >= dictionary->max_values,ERROR_FULL_DICTIONARY);
+    if (dictionary->num_values == dictionary->capacity)
+        util_grow_dictionary(dictionary);
+    dictionary->values[dictionary->num_values] = value;
+    *util_dictionary_slot(dictionary,value) = dictionary->num_values + 1;
+    return dictionary->num_values++;
+}
 
-    memcpy(copy->data_buffer,CURRENT_BUFFER->data_buffer + startidx * size,(endidx - startidx) * size);
+void util_encode_values(struct construct_dictionary* dictionary, unsigned int num_values, long long* values)
+{
+    unsigned int i;
+    for (i = 0; i < num_values; i++)
+        values[i] = util_encode(dictionary,values[i]);
+}
 
-    return copy;
+void util_decode_values(struct construct_dictionary* dictionary, unsigned int num_values, long long* values)
+{
+    unsigned int i;
+    for (i = 0; i < num_values; i++)
+        values[i] = dictionary->values[values[i]];
 }
 
-buffer copy_partial_buffer(buffer target, unsigned int startidx, unsigned int endidx)
+static struct construct_dictionary* util_get_dictionary(buffer target, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
-    error_if(startidx > endidx,ERROR_INVALID_INDEX);
-    error_if(endidx >= get_buffer_length(target),ERROR_OUT_OF_BOUNDS_INDEX);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(!util_is_encoded_type(target->types[field]),ERROR_INVALID_TYPE);
     #endif
-
-    buffer copy = malloc(sizeof(struct buffer));
-    copy->iterator = target->iterator;
-
-    unsigned int i, size = util_get_size(target);
-    copy->num_types = target->num_types;
-    copy->types = malloc(sizeof(enum construct_types) * copy->num_types);
-    for (i = 0; i < target->num_types; i++)
-        copy->types[i] = target->types[i];
-
-    copy->data_buffer = malloc((endidx - startidx) * size);
-    copy->num_elements = endidx - startidx;
-
-    memcpy(copy->data_buffer,target->data_buffer + startidx * size,(endidx - startidx) * size);
-
-    return copy;
+    return target->dictionaries[field];
 }
 
-void replace_inside_buffer(buffer target, unsigned int idxsrc, unsigned int idxdest)
+unsigned int get_buffer_code(buffer target, unsigned int element, unsigned int field)
 {
     #ifdef ERROR_CHECKING
     error_if(target == NULL,ERROR_BAD_BUFFER);
-    error_if(idxsrc >= target->num_elements || idxdest >= target->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(!util_is_encoded_type(target->types[field]),ERROR_INVALID_TYPE);
     #endif
 
-    unsigned int size = util_get_size(target);
-    memcpy(target->data_buffer + size * idxdest,target->data_buffer + size * idxsrc,size);
+    if (target->types[field] == DICT8)
+        return cast_to(unsigned char)get_buffer_field(target,element,field);
+    return cast_to(unsigned short)get_buffer_field(target,element,field);
 }
 
-void replace_inside(unsigned int idxsrc, unsigned int idxdest)
+long long get_buffer_fielde(buffer target, unsigned int element, unsigned int field)
 {
+    struct construct_dictionary* dictionary = util_get_dictionary(target,field);
+    unsigned int code = get_buffer_code(target,element,field);
     #ifdef ERROR_CHECKING
-    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
-    error_if(idxsrc >= CURRENT_BUFFER->num_elements || idxdest >= CURRENT_BUFFER->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
+    error_if(code >= dictionary->num_values,ERROR_OUT_OF_BOUNDS_INDEX);
     #endif
 
-    unsigned int size = util_get_size(CURRENT_BUFFER);
-    memcpy(CURRENT_BUFFER->data_buffer + size * idxdest,CURRENT_BUFFER->data_buffer + size * idxsrc,size);
+    return dictionary->values[code];
 }
 
-buffer init_bufferve(unsigned int num_elements, unsigned int num_types, enum construct_types* types)
+void set_buffer_fielde(buffer target, unsigned int element, unsigned int field, long long data)
 {
-    #ifdef ERROR_CHECKING
-    error_if(types == NULL,ERROR_BAD_TYPES);
-    #endif
-
-    buffer target;
-    target = malloc(sizeof(struct buffer));
-    target->num_types = num_types;
-    target->iterator = -1;
-    target->types = malloc(sizeof(enum construct_types) * num_types);
-    memcpy(target->types,types,sizeof(enum construct_types) * num_types);
-
-    unsigned int size = util_get_size(target);
-
-    target->data_buffer = malloc(num_elements * size);
-    target->num_elements = num_elements;
-
-    return target;
+    unsigned int code = util_encode(util_get_dictionary(target,field),data);
+    util_prepare_write(target);
 
+    if (target->types[field] == DICT8)
+        cast_to(unsigned char)get_buffer_field(target,element,field) = (unsigned char)code;
+    else
+        cast_to(unsigned short)get_buffer_field(target,element,field) = (unsigned short)code;
 }
 
-buffer init_bufferva(unsigned int num_elements, unsigned int num_types, ...)
+long long get_fielde(unsigned int field)
 {
-    va_list types;
-    va_start(types,num_types);
-
-    enum construct_types* buffer_types = malloc(sizeof(enum construct_types) * num_types);
-    unsigned int i;
-    for (i = 0; i < num_types; i++)
-        buffer_types[i] = va_arg(types,enum construct_types);
-    va_end(types);
-
-    buffer target;
-    target = malloc(sizeof(struct buffer));
-    target->num_types = num_types;
-
-    target->iterator = -1;
-
     #ifdef ERROR_CHECKING
-    error_if(num_types == 0,ERROR_NO_PUSHED_TYPES);
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
     #endif
 
-    target->types = buffer_types;
-
-    
-    unsigned int size = util_get_size(target);
-
-    target->data_buffer = malloc(num_elements * size);
-    target->num_elements = num_elements;
-
-    return target;   
+    return get_buffer_fielde(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field);
 }
 
-void* get_pointer(unsigned int field)
-{
-    return CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field);
-}
-void* get_buffer_pointer(buffer target, unsigned int element, unsigned int field)
+void set_fielde(unsigned int field, long long data)
 {
-    return target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field);
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    set_buffer_fielde(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,data);
 }
 
-unsigned int* get_buffer_pointerui(buffer target, unsigned int element, unsigned int field)
+unsigned int get_dictionary_size(buffer target, unsigned int field)
 {
-    return (unsigned int*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+    return util_get_dictionary(target,field)->num_values;
 }
-unsigned int* get_pointerui(unsigned int field)
+
+long long get_dictionary_value(buffer target, unsigned int field, unsigned int code)
 {
-    return (unsigned int*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+    struct construct_dictionary* dictionary = util_get_dictionary(target,field);
+    #ifdef ERROR_CHECKING
+    error_if(code >= dictionary->num_values,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+
+    return dictionary->values[code];
 }
 
-int* get_buffer_pointeri(buffer target, unsigned int element, unsigned int field)
+unsigned int find_dictionary_code(buffer target, unsigned int field, long long value)
 {
-    return (int*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+    return util_find_code(util_get_dictionary(target,field),value);
 }
-int* get_pointeri(unsigned int field)
+
+unsigned int filter_buffer_encoded(buffer target, unsigned int field, long long value, unsigned long* mask)
 {
-    return (int*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+    #ifdef ERROR_CHECKING
+    error_if(mask == NULL,ERROR_INVALID_DATA);
+    #endif
+    unsigned int i, count = 0, code = find_dictionary_code(target,field,value);
+    const unsigned char* codes = (const unsigned char*)target->data_buffer + target->offsets[field];
+    for (i = 0; i < (target->num_elements + CONSTRUCT_MASK_BITS - 1) / CONSTRUCT_MASK_BITS; i++)
+        mask[i] = 0;
+    if (code == (unsigned int)-1)
+        return 0;
+
+    if (target->types[field] == DICT8)
+    {
+        for (i = 0; i < target->num_elements; i++, codes += target->stride)
+            if (*codes == code)
+            {
+                mask[i / CONSTRUCT_MASK_BITS] |= 1ul << (i % CONSTRUCT_MASK_BITS);
+                count++;
+            }
+    }
+    else
+    {
+        for (i = 0; i < target->num_elements; i++, codes += target->stride)
+            if (*(const unsigned short*)codes == code)
+            {
+                mask[i / CONSTRUCT_MASK_BITS] |= 1ul << (i % CONSTRUCT_MASK_BITS);
+                count++;
+            }
+    }
+    return count;
 }
 
-float* get_buffer_pointerf(buffer target, unsigned int element, unsigned int field)
+unsigned int util_is_integer_type(enum construct_types type)
 {
-    return (float*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+    return type != FLOAT && type != DOUBLE && type != HALF && type != VOID && type != BIT && type != STR16 && type != STR32 && type != STRING && type != NESTED;
 }
-float* get_pointerf(unsigned int field)
+
+void util_load_integers(enum construct_types type, const unsigned char* src, unsigned int stride, unsigned int num_values, long long* values)
 {
-    return (float*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
-}
-
-char* get_buffer_pointerc(buffer target, unsigned int element, unsigned int field)
-{
-    return (char*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
-}
-char* get_pointerc(unsigned int field)
-{
-    return (char*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
-}
-
-unsigned char* get_buffer_pointeruc(buffer target, unsigned int element, unsigned int field)
-{
-    return (unsigned char*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
-}
-unsigned char* get_pointeruc(unsigned int field)
-{
-    return (unsigned char*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
-}
-
-void** get_buffer_pointerv(buffer target, unsigned int element, unsigned int field)
-{
-    return (void**)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
-}
-void** get_pointerv(unsigned int field)
-{
-    return (void**)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
-}
-
-void* get_element_pointer()
-{
-    return CURRENT_BUFFER->data_buffer + get_element_data_offset(CURRENT_BUFFER->iterator);
-}
-
-void* get_buffer_element_pointer(buffer target, unsigned int element)
-{
-    return target->data_buffer + get_buffer_element_data_offset(target,element);
-}
-
-
-void mul_field(unsigned int field, float factor)
-{
-    switch(CURRENT_BUFFER->types[field])
+    unsigned int i;
+    switch(type)
     {
         case UINT:
-        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned int*)(src + stride * i);
         break;
         case INT:
-        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const int*)(src + stride * i);
         break;
         case CHAR:
-        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const char*)(src + stride * i);
         break;
         case UCHAR:
-        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned char*)(src + stride * i);
         break;
-        case FLOAT:
-        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        case INT8:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const signed char*)(src + stride * i);
         break;
-        case VOID:
-        default:
-        #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
-        #endif
+        case INT16:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const short*)(src + stride * i);
         break;
-    }
-}
-
-void div_field(unsigned int field, float factor)
-{
-    switch(CURRENT_BUFFER->types[field])
-    {
-        case UINT:
-        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        case UINT16:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned short*)(src + stride * i);
         break;
-        case INT:
-        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        case INT64:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const long long*)(src + stride * i);
         break;
-        case CHAR:
-        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        case UINT64:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned long long*)(src + stride * i);
         break;
-        case UCHAR:
-        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        case DICT8:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned char*)(src + stride * i);
         break;
-        case FLOAT:
-        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        case DICT16:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned short*)(src + stride * i);
         break;
-        case VOID:
         default:
-        #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
-        #endif
         break;
     }
 }
 
-void add_field(unsigned int field, float factor)
+void util_store_integers(enum construct_types type, unsigned char* dest, unsigned int stride, unsigned int num_values, const long long* values)
 {
-    switch(CURRENT_BUFFER->types[field])
+    unsigned int i;
+    switch(type)
     {
         case UINT:
-        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        for (i = 0; i < num_values; i++)
+            *(unsigned int*)(dest + stride * i) = (unsigned int)values[i];
         break;
         case INT:
-        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        for (i = 0; i < num_values; i++)
+            *(int*)(dest + stride * i) = (int)values[i];
         break;
         case CHAR:
-        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        for (i = 0; i < num_values; i++)
+            *(char*)(dest + stride * i) = (char)values[i];
         break;
         case UCHAR:
-        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
-        break;
-        case FLOAT:
-        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
-        break;
-        case VOID:
-        set_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + (int)factor);
+        for (i = 0; i < num_values; i++)
+            *(unsigned char*)(dest + stride * i) = (unsigned char)values[i];
         break;
-        default:
-        #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
-        #endif
+        case INT8:
+        for (i = 0; i < num_values; i++)
+            *(signed char*)(dest + stride * i) = (signed char)values[i];
         break;
-    }
-}
-
-void sub_field(unsigned int field, float factor)
-{
-    switch(CURRENT_BUFFER->types[field])
-    {
-        case UINT:
-        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        case INT16:
+        for (i = 0; i < num_values; i++)
+            *(short*)(dest + stride * i) = (short)values[i];
         break;
-        case INT:
-        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        case UINT16:
+        for (i = 0; i < num_values; i++)
+            *(unsigned short*)(dest + stride * i) = (unsigned short)values[i];
         break;
-        case CHAR:
-        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        case INT64:
+        for (i = 0; i < num_values; i++)
+            *(long long*)(dest + stride * i) = (long long)values[i];
         break;
-        case UCHAR:
-        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        case UINT64:
+        for (i = 0; i < num_values; i++)
+            *(unsigned long long*)(dest + stride * i) = (unsigned long long)values[i];
         break;
-        case FLOAT:
-        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        case DICT8:
+        for (i = 0; i < num_values; i++)
+            *(unsigned char*)(dest + stride * i) = (unsigned char)values[i];
         break;
-        case VOID:
-        set_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - (int)factor);
+        case DICT16:
+        for (i = 0; i < num_values; i++)
+            *(unsigned short*)(dest + stride * i) = (unsigned short)values[i];
         break;
         default:
-        #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
-        #endif
         break;
     }
 }
 
-void mul_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
+void util_load_reals(enum construct_types type, const unsigned char* src, unsigned int stride, unsigned int num_values, double* values)
 {
-    switch(target->types[field])
+    unsigned short halves[CONSTRUCT_CONVERT_CHUNK];
+    float floats[CONSTRUCT_CONVERT_CHUNK];
+    unsigned int i;
+    switch(type)
     {
         case UINT:
-        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned int*)(src + stride * i);
         break;
         case INT:
-        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const int*)(src + stride * i);
+        break;
+        case FLOAT:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const float*)(src + stride * i);
         break;
         case CHAR:
-        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const char*)(src + stride * i);
         break;
         case UCHAR:
-        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) * factor);
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned char*)(src + stride * i);
         break;
-        case FLOAT:
-        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) * factor);
+        case INT8:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const signed char*)(src + stride * i);
         break;
-        case VOID:
-        default:
-        #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
-        #endif
+        case INT16:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const short*)(src + stride * i);
         break;
-    }
-}
-
-void div_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
-{
-    switch(target->types[field])
-    {
-        case UINT:
-        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) / factor);
+        case UINT16:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned short*)(src + stride * i);
         break;
-        case INT:
-        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) / factor);
+        case INT64:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const long long*)(src + stride * i);
         break;
-        case CHAR:
-        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) / factor);
+        case UINT64:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const unsigned long long*)(src + stride * i);
         break;
-        case UCHAR:
-        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) / factor);
+        case DOUBLE:
+        for (i = 0; i < num_values; i++)
+            values[i] = *(const double*)(src + stride * i);
         break;
-        case FLOAT:
-        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) / factor);
+        case HALF:
+        for (i = 0; i < num_values; i++)
+            halves[i] = *(const unsigned short*)(src + stride * i);
+        util_halves_to_floats(halves,floats,num_values);
+        for (i = 0; i < num_values; i++)
+            values[i] = floats[i];
         break;
-        case VOID:
         default:
-        #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
-        #endif
         break;
     }
 }
 
-void add_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
+void util_store_reals(enum construct_types type, unsigned char* dest, unsigned int stride, unsigned int num_values, const double* values)
 {
-    switch(target->types[field])
+    unsigned short halves[CONSTRUCT_CONVERT_CHUNK];
+    float floats[CONSTRUCT_CONVERT_CHUNK];
+    unsigned int i;
+    switch(type)
     {
         case UINT:
-        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) + factor);
+        for (i = 0; i < num_values; i++)
+            *(unsigned int*)(dest + stride * i) = (unsigned int)values[i];
         break;
         case INT:
-        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) + factor);
+        for (i = 0; i < num_values; i++)
+            *(int*)(dest + stride * i) = (int)values[i];
+        break;
+        case FLOAT:
+        for (i = 0; i < num_values; i++)
+            *(float*)(dest + stride * i) = (float)values[i];
         break;
         case CHAR:
-        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) + factor);
+        for (i = 0; i < num_values; i++)
+            *(char*)(dest + stride * i) = (char)values[i];
         break;
         case UCHAR:
-        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) + factor);
+        for (i = 0; i < num_values; i++)
+            *(unsigned char*)(dest + stride * i) = (unsigned char)values[i];
         break;
-        case FLOAT:
-        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) + factor);
+        case INT8:
+        for (i = 0; i < num_values; i++)
+            *(signed char*)(dest + stride * i) = (signed char)values[i];
         break;
-        case VOID:
-        set_buffer_fieldv(target,element,field,get_buffer_fieldv(target,element,field) + (int)factor);
+        case INT16:
+        for (i = 0; i < num_values; i++)
+            *(short*)(dest + stride * i) = (short)values[i];
+        break;
+        case UINT16:
+        for (i = 0; i < num_values; i++)
+            *(unsigned short*)(dest + stride * i) = (unsigned short)values[i];
+        break;
+        case INT64:
+        for (i = 0; i < num_values; i++)
+            *(long long*)(dest + stride * i) = (long long)values[i];
+        break;
+        case UINT64:
+        for (i = 0; i < num_values; i++)
+            *(unsigned long long*)(dest + stride * i) = (unsigned long long)values[i];
+        break;
+        case DOUBLE:
+        for (i = 0; i < num_values; i++)
+            *(double*)(dest + stride * i) = (double)values[i];
+        break;
+        case HALF:
+        for (i = 0; i < num_values; i++)
+            floats[i] = (float)values[i];
+        util_floats_to_halves(floats,halves,num_values);
+        for (i = 0; i < num_values; i++)
+            *(unsigned short*)(dest + stride * i) = halves[i];
         break;
         default:
-        #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
-        #endif
         break;
     }
 }
 
-void sub_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
+void convert_buffer_field(buffer src, unsigned int src_field, buffer dest, unsigned int dest_field)
 {
-    switch(target->types[field])
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    error_if(src_field >= src->num_types || dest_field >= dest->num_types,ERROR_INVALID_FIELD);
+    error_if(src->types[src_field] == VOID || dest->types[dest_field] == VOID,ERROR_INVALID_TYPE);
+    error_if(src->types[src_field] == BIT || dest->types[dest_field] == BIT,ERROR_INVALID_TYPE);
+    error_if(!util_is_integer_type(src->types[src_field]) && src->types[src_field] > BIT,ERROR_INVALID_TYPE);
+    error_if(!util_is_integer_type(dest->types[dest_field]) && dest->types[dest_field] > BIT,ERROR_INVALID_TYPE);
+    error_if(util_is_encoded_type(src->types[src_field]) && !util_is_integer_type(dest->types[dest_field]),ERROR_INVALID_TYPE);
+    error_if(util_is_encoded_type(dest->types[dest_field]) && !util_is_integer_type(src->types[src_field]),ERROR_INVALID_TYPE);
+    error_if(dest->num_elements < src->num_elements,ERROR_SMALL_DEST_BUFFER);
+    #endif
+    util_prepare_write(dest);
+
+    enum construct_types src_type = src->types[src_field], dest_type = dest->types[dest_field];
+    const unsigned char* from = (const unsigned char*)src->data_buffer + src->offsets[src_field];
+    unsigned char* to = (unsigned char*)dest->data_buffer + dest->offsets[dest_field];
+    unsigned int i, num_values;
+    for (i = 0; i < src->num_elements; i += num_values)
+    {
+        num_values = src->num_elements - i < CONSTRUCT_CONVERT_CHUNK ? src->num_elements - i : CONSTRUCT_CONVERT_CHUNK;
+        if (util_is_integer_type(src_type) && util_is_integer_type(dest_type))
+        {
+            long long values[CONSTRUCT_CONVERT_CHUNK];
+            util_load_integers(src_type,from + src->stride * i,src->stride,num_values,values);
+            if (util_is_encoded_type(src_type))
+                util_decode_values(src->dictionaries[src_field],num_values,values);
+            if (util_is_encoded_type(dest_type))
+                util_encode_values(dest->dictionaries[dest_field],num_values,values);
+            util_store_integers(dest_type,to + dest->stride * i,dest->stride,num_values,values);
+        }
+        else
+        {
+            double values[CONSTRUCT_CONVERT_CHUNK];
+            util_load_reals(src_type,from + src->stride * i,src->stride,num_values,values);
+            util_store_reals(dest_type,to + dest->stride * i,dest->stride,num_values,values);
+        }
+    }
+}
+
+void convert_field(unsigned int src_field, unsigned int dest_field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    convert_buffer_field(CURRENT_BUFFER,src_field,CURRENT_BUFFER,dest_field);
+}
+
+static unsigned int util_popcount(unsigned long bits)
+{
+    #ifdef __GNUC__
+    return __builtin_popcountl(bits);
+    #else
+    unsigned int count = 0;
+    for (; bits != 0; bits &= bits - 1)
+        count++;
+    return count;
+    #endif
+}
+
+unsigned int count_mask_bits(const unsigned long* mask, unsigned int num_bits)
+{
+    #ifdef ERROR_CHECKING
+    error_if(mask == NULL && num_bits != 0,ERROR_INVALID_DATA);
+    #endif
+    unsigned int i, count = 0;
+    for (i = 0; i < num_bits / CONSTRUCT_MASK_BITS; i++)
+        count += util_popcount(mask[i]);
+    if (num_bits % CONSTRUCT_MASK_BITS != 0)
+        count += util_popcount(mask[i] & ((1ul << (num_bits % CONSTRUCT_MASK_BITS)) - 1));
+    return count;
+}
+
+unsigned int filter_buffer_bits(buffer target, unsigned int num_fields, const unsigned int* fields, const unsigned int* values, unsigned long* mask)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(mask == NULL || (num_fields != 0 && (fields == NULL || values == NULL)),ERROR_INVALID_DATA);
+    #endif
+    unsigned int i, j, count = 0, first_bit = target->offsets[target->num_types], last_bit = 0;
+    for (j = 0; j < num_fields; j++)
     {
-        case UINT:
-        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) - factor);
-        break;
-        case INT:
-        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) - factor);
-        break;
-        case CHAR:
-        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) - factor);
-        break;
-        case UCHAR:
-        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) - factor);
-        break;
-        case FLOAT:
-        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) - factor);
-        break;
-        case VOID:
-        set_buffer_fieldv(target,element,field,get_buffer_fieldv(target,element,field) - (int)factor);
-        break;
-        default:
         #ifdef ERROR_CHECKING
-        error_if(0,ERROR_INVALID_TYPE);
+        error_if(fields[j] >= target->num_types,ERROR_INVALID_FIELD);
+        error_if(target->types[fields[j]] != BIT,ERROR_INVALID_TYPE);
         #endif
-        break;
+        first_bit = target->offsets[fields[j]] < first_bit ? target->offsets[fields[j]] : first_bit;
+        last_bit = target->offsets[fields[j]] > last_bit ? target->offsets[fields[j]] : last_bit;
+    }
+    for (i = 0; i < (target->num_elements + CONSTRUCT_MASK_BITS - 1) / CONSTRUCT_MASK_BITS; i++)
+        mask[i] = 0;
+
+    const unsigned char* element = (const unsigned char*)target->data_buffer;
+    if (num_fields != 0 && last_bit - first_bit < sizeof(unsigned long))
+    {
+        unsigned long care = 0, want = 0, bits;
+        unsigned int width = last_bit - first_bit + 1;
+        for (j = 0; j < num_fields; j++)
+        {
+            unsigned long bit = (unsigned long)target->offsets[target->num_types + 1 + fields[j]] << ((target->offsets[fields[j]] - first_bit) * 8);
+            care |= bit;
+            want = values[j] ? want | bit : want & ~bit;
+        }
+        element += first_bit;
+        for (i = 0; i < target->num_elements; i++, element += target->stride)
+        {
+            bits = 0;
+            for (j = 0; j < width; j++)
+                bits |= (unsigned long)element[j] << (j * 8);
+            if ((bits & care) == want)
+            {
+                mask[i / CONSTRUCT_MASK_BITS] |= 1ul << (i % CONSTRUCT_MASK_BITS);
+                count++;
+            }
+        }
+        return count;
+    }
+    for (i = 0; i < target->num_elements; i++, element += target->stride)
+    {
+        for (j = 0; j < num_fields; j++)
+            if (((element[target->offsets[fields[j]]] & target->offsets[target->num_types + 1 + fields[j]]) != 0) != (values[j] != 0))
+                break;
+        if (j == num_fields)
+        {
+            mask[i / CONSTRUCT_MASK_BITS] |= 1ul << (i % CONSTRUCT_MASK_BITS);
+            count++;
+        }
+    }
+    return count;
+}
+
+unsigned int count_buffer_bits(buffer target, unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(target->types[field] != BIT,ERROR_INVALID_TYPE);
+    #endif
+    const unsigned char* bits = (const unsigned char*)target->data_buffer + target->offsets[field];
+    unsigned int i, count = 0, mask = target->offsets[target->num_types + 1 + field];
+    unsigned long word, shift;
+    if (target->stride == 1)
+    {
+        for (i = 0; i + sizeof(unsigned long) <= target->num_elements; i += sizeof(unsigned long), bits += sizeof(unsigned long))
+        {
+            memcpy(&word,bits,sizeof(unsigned long));
+            count += util_popcount(word & (~0ul / 0xff) * mask);
+        }
     }
+    else
+    {
+        for (i = 0; i + CONSTRUCT_MASK_BITS <= target->num_elements; i += CONSTRUCT_MASK_BITS)
+        {
+            for (word = 0, shift = 0; shift < CONSTRUCT_MASK_BITS; shift++, bits += target->stride)
+                word |= (unsigned long)((*bits & mask) != 0) << shift;
+            count += util_popcount(word);
+        }
+    }
+    for (; i < target->num_elements; i++, bits += target->stride)
+        count += (*bits & mask) != 0;
+    return count;
+}
+
+unsigned int count_bits(unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return count_buffer_bits(CURRENT_BUFFER,field);
+}
+
+static char* POOL_CHARS = NULL;
+static unsigned int POOL_NUM_CHARS = 0, POOL_CHAR_CAPACITY = 0;
+/* Outgrown chars stay allocated until the pool is cleared, since the strings returned by get_interned_string() still point into them */
+static char* POOL_OLD_CHARS[32];
+static unsigned int POOL_NUM_OLD_CHARS = 0;
+static unsigned int* POOL_STRINGS = NULL;
+static unsigned int POOL_NUM_STRINGS = 0, POOL_STRING_CAPACITY = 0;
+static unsigned int* POOL_TABLE = NULL;
+static unsigned int POOL_TABLE_SIZE = 0;
+/* With "CONSTRUCT_THREADS" any thread may intern and look up strings, so the pool is only touched under a lock */
+#ifdef CONSTRUCT_THREADS
+    #include <pthread.h>
+
+    static pthread_mutex_t POOL_LOCK = PTHREAD_MUTEX_INITIALIZER;
+    #define util_lock_pool()        pthread_mutex_lock(&POOL_LOCK)
+    #define util_unlock_pool()      pthread_mutex_unlock(&POOL_LOCK)
+#else
+    #define util_lock_pool()
+    #define util_unlock_pool()
+#endif
+
+static unsigned int util_pool_hash(const char* data)
+{
+    unsigned int hash = 2166136261u;
+    for (; *data != '\0'; data++)
+        hash = (hash ^ (unsigned char)*data) * 16777619u;
+    return hash;
+}
+
+static unsigned int* util_pool_slot(const char* data)
+{
+    unsigned int slot = util_pool_hash(data) & (POOL_TABLE_SIZE - 1);
+    while (POOL_TABLE[slot] != 0 && strcmp(POOL_CHARS + POOL_STRINGS[POOL_TABLE[slot] - 1],data) != 0)
+        slot = (slot + 1) & (POOL_TABLE_SIZE - 1);
+    return POOL_TABLE + slot;
+}
+
+static void util_pool_grow_table()
+{
+    unsigned int i;
+    free(POOL_TABLE);
+    POOL_TABLE_SIZE = POOL_TABLE_SIZE == 0 ? 64 : POOL_TABLE_SIZE * 2;
+    POOL_TABLE = malloc(sizeof(unsigned int) * POOL_TABLE_SIZE);
+    memset(POOL_TABLE,0,sizeof(unsigned int) * POOL_TABLE_SIZE);
+    for (i = 0; i < POOL_NUM_STRINGS; i++)
+        *util_pool_slot(POOL_CHARS + POOL_STRINGS[i]) = i + 1;
+}
+
+static unsigned int util_pool_add(const char* data, unsigned int length)
+{
+    if (POOL_NUM_CHARS + length + 1 > POOL_CHAR_CAPACITY)
+    {
+        char* chars;
+        while (POOL_NUM_CHARS + length + 1 > POOL_CHAR_CAPACITY)
+            POOL_CHAR_CAPACITY = POOL_CHAR_CAPACITY == 0 ? 256 : POOL_CHAR_CAPACITY * 2;
+        chars = malloc(POOL_CHAR_CAPACITY);
+        if (POOL_CHARS != NULL)
+        {
+            memcpy(chars,POOL_CHARS,POOL_NUM_CHARS);
+            POOL_OLD_CHARS[POOL_NUM_OLD_CHARS++] = POOL_CHARS;
+        }
+        POOL_CHARS = chars;
+    }
+    if (POOL_NUM_STRINGS == POOL_STRING_CAPACITY)
+    {
+        POOL_STRING_CAPACITY = POOL_STRING_CAPACITY == 0 ? 32 : POOL_STRING_CAPACITY * 2;
+        POOL_STRINGS = realloc(POOL_STRINGS,sizeof(unsigned int) * POOL_STRING_CAPACITY);
+    }
+    memcpy(POOL_CHARS + POOL_NUM_CHARS,data,length + 1);
+    POOL_STRINGS[POOL_NUM_STRINGS] = POOL_NUM_CHARS;
+    POOL_NUM_CHARS += length + 1;
+    return POOL_NUM_STRINGS++;
+}
+
+static void util_pool_init()
+{
+    if (POOL_NUM_STRINGS != 0)
+        return;
+    util_pool_add("",0);
+    util_pool_grow_table();
+}
+
+unsigned int intern_string(const char* data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(data == NULL,ERROR_INVALID_DATA);
+    #endif
+    unsigned int id;
+    util_lock_pool();
+    util_pool_init();
+
+    unsigned int* slot = util_pool_slot(data);
+    if (*slot != 0)
+        id = *slot - 1;
+    else
+    {
+        id = util_pool_add(data,strlen(data));
+        *slot = id + 1;
+        if (POOL_NUM_STRINGS * 2 > POOL_TABLE_SIZE)
+            util_pool_grow_table();
+    }
+    util_unlock_pool();
+    return id;
+}
+
+unsigned int find_interned_string(const char* data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(data == NULL,ERROR_INVALID_DATA);
+    #endif
+    unsigned int id;
+    util_lock_pool();
+    util_pool_init();
+
+    id = *util_pool_slot(data) - 1;
+    util_unlock_pool();
+    return id;
+}
+
+const char* get_interned_string(unsigned int id)
+{
+    const char* string;
+    util_lock_pool();
+    util_pool_init();
+    #ifdef ERROR_CHECKING
+    error_if(id >= POOL_NUM_STRINGS,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+
+    string = POOL_CHARS + POOL_STRINGS[id];
+    util_unlock_pool();
+    return string;
+}
+
+unsigned int get_num_interned_strings()
+{
+    unsigned int num_strings;
+    util_lock_pool();
+    util_pool_init();
+    num_strings = POOL_NUM_STRINGS;
+    util_unlock_pool();
+    return num_strings;
+}
+
+static void util_pool_clear()
+{
+    unsigned int i;
+    for (i = 0; i < POOL_NUM_OLD_CHARS; i++)
+        free(POOL_OLD_CHARS[i]);
+    free(POOL_CHARS);
+    free(POOL_STRINGS);
+    free(POOL_TABLE);
+    POOL_CHARS = NULL;
+    POOL_STRINGS = POOL_TABLE = NULL;
+    POOL_NUM_CHARS = POOL_CHAR_CAPACITY = POOL_NUM_STRINGS = POOL_STRING_CAPACITY = POOL_TABLE_SIZE = POOL_NUM_OLD_CHARS = 0;
+}
+
+void clear_string_pool()
+{
+    util_lock_pool();
+    util_pool_clear();
+    util_unlock_pool();
+}
+
+void* dump_string_pool_binary(unsigned int* size)
+{
+    util_lock_pool();
+    util_pool_init();
+
+    void* bin_data = malloc(POOL_NUM_CHARS);
+    memcpy(bin_data,POOL_CHARS,POOL_NUM_CHARS);
+    if (size != NULL)
+        *size = POOL_NUM_CHARS;
+    util_unlock_pool();
+    return bin_data;
+}
+
+void load_string_pool_binary(void* bin_data, unsigned int size)
+{
+    #ifdef ERROR_CHECKING
+    error_if(bin_data == NULL,ERROR_INVALID_DATA);
+    error_if(size == 0 || ((char*)bin_data)[size - 1] != '\0',ERROR_INVALID_DATA);
+    #endif
+    const char* data = bin_data;
+    unsigned int offset, length;
+
+    util_lock_pool();
+    util_pool_clear();
+    util_pool_init();
+    for (offset = 1; offset < size; offset += length + 1)
+    {
+        length = strlen(data + offset);
+        *util_pool_slot(data + offset) = util_pool_add(data + offset,length) + 1;
+        if (POOL_NUM_STRINGS * 2 > POOL_TABLE_SIZE)
+            util_pool_grow_table();
+    }
+    util_unlock_pool();
+}
+
+void repush_buffer_types(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    unsigned int i;
+    for (i = 0; i < target->num_types; i++)
+        push_type(target->types[i]);
+}
+
+void repush_types()
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    unsigned int i;
+    for (i = 0; i < CURRENT_BUFFER->num_types; i++)
+        push_type(CURRENT_BUFFER->types[i]);
+}
+
+buffer create_single_buffer_element(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    return util_create_buffer_like(1,target);
+}
+
+buffer create_single_element()
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return util_create_buffer_like(1,CURRENT_BUFFER);
+}
+
+void copy_to_buffer(buffer dest)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    error_if(get_buffer_element_size(dest) != get_buffer_element_size(CURRENT_BUFFER),ERROR_UNEQUAL_ELEMENT_SIZE);
+    error_if(dest->num_elements < CURRENT_BUFFER->num_elements, ERROR_SMALL_DEST_BUFFER);
+    #endif
+    util_prepare_write(dest);
+    util_copy_elements(dest,0,CURRENT_BUFFER,0,CURRENT_BUFFER->num_elements);
+}
+
+void copy_from_buffer(buffer src)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(get_buffer_element_size(CURRENT_BUFFER) != get_buffer_element_size(src),ERROR_UNEQUAL_ELEMENT_SIZE);
+    error_if(CURRENT_BUFFER->num_elements < src->num_elements, ERROR_SMALL_DEST_BUFFER);
+    #endif
+    util_prepare_write(CURRENT_BUFFER);
+    util_copy_elements(CURRENT_BUFFER,0,src,0,src->num_elements);
+}
+
+void copy_buffer_to_buffer(buffer src,buffer dest)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    error_if(get_buffer_element_size(dest) != get_buffer_element_size(src),ERROR_UNEQUAL_ELEMENT_SIZE);
+    error_if(dest->num_elements < src->num_elements, ERROR_SMALL_DEST_BUFFER);
+    #endif
+    util_prepare_write(dest);
+    util_copy_elements(dest,0,src,0,src->num_elements);
+}
+
+buffer copy_buffer(buffer src)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    #endif
+    buffer copy = util_create_buffer_like(src->num_elements,src);
+    copy->iterator = src->iterator;
+    copy->sorted_by = src->sorted_by;
+
+    util_copy_elements(copy,0,src,0,src->num_elements);
+
+    return copy;
+}
+
+
+buffer copy_buffer_cow(buffer src)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    #endif
+    /* Views point into the data buffer of the buffer they view, so a buffer with live views can't give it up on its first write */
+    if (src->parent != NULL || src->arena != NULL || util_load_references(src->num_views) != 0)
+        return copy_buffer(src);
+
+    buffer copy = malloc(sizeof(struct buffer));
+    *copy = *src;
+    copy->types = util_copy_types(src);
+    copy->offsets = util_compute_offsets(copy->num_types,copy->types);
+    copy->dictionaries = NULL;
+    util_share_dictionaries(copy,src);
+    memset(&copy->stats,0,sizeof(struct construct_stats));
+
+    if (src->references == NULL)
+    {
+        src->references = malloc(sizeof(unsigned int));
+        *src->references = 1;
+    }
+    util_acquire_reference(*src->references);
+    copy->references = src->references;
+    register_buffer(copy);
+
+    return copy;
+}
+
+#define CONSTRUCT_ARENA_ALIGNMENT 16
+#define util_arena_align(bytes) (((bytes) + CONSTRUCT_ARENA_ALIGNMENT - 1) & ~(unsigned long)(CONSTRUCT_ARENA_ALIGNMENT - 1))
+
+static unsigned long util_arena_node_bytes(unsigned int num_types, unsigned int num_elements, unsigned int element_size, unsigned int encoded)
+{
+    return util_arena_align(sizeof(struct buffer)) + util_arena_align(sizeof(enum construct_types) * num_types)
+        + util_arena_align(sizeof(unsigned int) * (2 * num_types + 1)) + (encoded ? util_arena_align(sizeof(struct construct_dictionary*) * num_types) : 0)
+        + util_arena_align((unsigned long)element_size * num_elements);
+}
+
+static buffer util_arena_node(unsigned char** cursor, void* arena, unsigned int num_types, const enum construct_types* types, unsigned int num_elements, unsigned int encoded)
+{
+    buffer node = (buffer)*cursor;
+    *cursor += util_arena_align(sizeof(struct buffer));
+    node->types = (enum construct_types*)*cursor;
+    memcpy(node->types,types,sizeof(enum construct_types) * num_types);
+    *cursor += util_arena_align(sizeof(enum construct_types) * num_types);
+    unsigned int* offsets = util_compute_offsets(num_types,node->types);
+    node->offsets = (unsigned int*)*cursor;
+    memcpy(node->offsets,offsets,sizeof(unsigned int) * (2 * num_types + 1));
+    free(offsets);
+    *cursor += util_arena_align(sizeof(unsigned int) * (2 * num_types + 1));
+    node->dictionaries = NULL;
+    if (encoded)
+    {
+        node->dictionaries = (struct construct_dictionary**)*cursor;
+        *cursor += util_arena_align(sizeof(struct construct_dictionary*) * num_types);
+    }
+    node->iterator = -1;
+    node->num_types = num_types;
+    node->num_elements = num_elements;
+    node->stride = node->offsets[num_types];
+    node->parent = NULL;
+    node->references = NULL;
+    node->arena = arena;
+    node->sorted_by = 0;
+    node->num_views = 0;
+    memset(&node->stats,0,sizeof(struct construct_stats));
+    node->data_buffer = *cursor;
+    *cursor += util_arena_align((unsigned long)node->stride * num_elements);
+    return node;
+}
+
+/* Nested buffer pointers sit at any offset of packed elements, so they are read and written bytewise */
+static buffer util_load_child(buffer target, unsigned int element, unsigned int field)
+{
+    buffer child;
+    memcpy(&child,get_buffer_field(target,element,field),sizeof(buffer));
+    return child;
+}
+
+static void util_store_child(buffer target, unsigned int element, unsigned int field, buffer child)
+{
+    memcpy(get_buffer_field(target,element,field),&child,sizeof(buffer));
+}
+
+static unsigned long util_deep_size(buffer src)
+{
+    unsigned long size = util_arena_node_bytes(src->num_types,src->num_elements,util_get_size(src),src->dictionaries != NULL);
+    unsigned int i, j;
+    for (j = 0; j < src->num_types; j++)
+        if (src->types[j] == NESTED)
+            for (i = 0; i < src->num_elements; i++)
+                if (util_load_child(src,i,j) != NULL)
+                    size += util_deep_size(util_load_child(src,i,j));
+    return size;
+}
+
+static buffer util_deep_copy(buffer src, unsigned char** cursor, void* arena)
+{
+    buffer node = util_arena_node(cursor,arena,src->num_types,src->types,src->num_elements,src->dictionaries != NULL);
+    unsigned int i, j;
+    if (node->dictionaries != NULL)
+        for (j = 0; j < src->num_types; j++)
+        {
+            node->dictionaries[j] = src->dictionaries[j];
+            if (node->dictionaries[j] != NULL)
+                node->dictionaries[j]->references++;
+        }
+    util_copy_elements(node,0,src,0,src->num_elements);
+    node->sorted_by = src->sorted_by;
+    for (j = 0; j < src->num_types; j++)
+        if (src->types[j] == NESTED)
+            for (i = 0; i < src->num_elements; i++)
+                if (util_load_child(src,i,j) != NULL)
+                    util_store_child(node,i,j,util_deep_copy(util_load_child(src,i,j),cursor,arena));
+    return node;
+}
+
+static buffer util_arena_root(unsigned long size, void** arena)
+{
+    *arena = malloc(util_arena_align(sizeof(unsigned long)) + size);
+    *(unsigned long*)*arena = size;
+    return (buffer)((unsigned char*)*arena + util_arena_align(sizeof(unsigned long)));
+}
+
+#ifdef CONSTRUCT_REGISTRY
+static void util_register_arena(buffer root)
+{
+    util_register_buffer(root);
+    struct construct_footprint footprint;
+    util_get_footprint(root,&footprint);
+    util_account_bytes((long)*(unsigned long*)root->arena - (long)footprint.peak_bytes);
+    root->peak_bytes = *(unsigned long*)root->arena;
+}
+    #define register_arena(root) util_register_arena(root)
+#else
+    #define register_arena(root) register_buffer(root)
+#endif
+
+static void util_release_arena_nodes(buffer target)
+{
+    unsigned int i, j;
+    buffer child;
+    if (target->dictionaries != NULL)
+        for (j = 0; j < target->num_types; j++)
+            util_release_dictionary(target->dictionaries[j]);
+    for (j = 0; j < target->num_types; j++)
+        if (target->types[j] == NESTED)
+            for (i = 0; i < target->num_elements; i++)
+                if ((child = util_load_child(target,i,j)) != NULL && child->arena == target->arena)
+                    util_release_arena_nodes(child);
+}
+
+void util_free_arena(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if((unsigned char*)target->arena + util_arena_align(sizeof(unsigned long)) != (unsigned char*)target,ERROR_ARENA_BUFFER);
+    #endif
+    if (target == CURRENT_BUFFER)
+        CURRENT_BUFFER = NULL;
+    unregister_buffer(target);
+    #ifdef CONSTRUCT_REGISTRY
+    struct construct_footprint footprint;
+    util_get_footprint(target,&footprint);
+    util_account_bytes((long)footprint.peak_bytes - (long)*(unsigned long*)target->arena);
+    #endif
+    void* arena = target->arena;
+    util_release_arena_nodes(target);
+    free(arena);
+}
+
+buffer copy_buffer_deep(buffer src)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    #endif
+    void* arena;
+    buffer root = util_arena_root(util_deep_size(src),&arena);
+    unsigned char* cursor = (unsigned char*)root;
+
+    util_deep_copy(src,&cursor,arena);
+    root->iterator = src->iterator;
+    register_arena(root);
+    return root;
+}
+
+void deinit_buffer_deep(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    unsigned int i, j;
+    buffer child;
+    for (j = 0; j < target->num_types; j++)
+        if (target->types[j] == NESTED)
+            for (i = 0; i < target->num_elements; i++)
+                if ((child = util_load_child(target,i,j)) != NULL && (child->arena == NULL || child->arena != target->arena))
+                    deinit_buffer_deep(child);
+    deinit_buffer(target);
+}
+
+static unsigned int util_deep_dump_size(buffer target)
+{
+    unsigned int i, j, size = sizeof(unsigned int) * (2 + target->num_types) + util_get_size(target) * target->num_elements;
+    buffer child;
+    for (j = 0; j < target->num_types; j++)
+    {
+        if (util_is_encoded_type(target->types[j]))
+            size += sizeof(unsigned int) + sizeof(long long) * target->dictionaries[j]->num_values;
+        if (target->types[j] == NESTED)
+            for (i = 0; i < target->num_elements; i++)
+                if ((child = util_load_child(target,i,j)) != NULL)
+                    size += util_deep_dump_size(child);
+    }
+    return size;
+}
+
+static void util_deep_dump(buffer target, unsigned char** cursor)
+{
+    unsigned int i, j, size = util_get_size(target), word;
+    buffer child;
+    memcpy(*cursor,&target->num_types,sizeof(unsigned int));
+    memcpy(*cursor + sizeof(unsigned int),&target->num_elements,sizeof(unsigned int));
+    *cursor += 2 * sizeof(unsigned int);
+    for (j = 0; j < target->num_types; j++, *cursor += sizeof(unsigned int))
+    {
+        word = target->types[j];
+        memcpy(*cursor,&word,sizeof(unsigned int));
+    }
+    for (j = 0; j < target->num_types; j++)
+        if (util_is_encoded_type(target->types[j]))
+        {
+            memcpy(*cursor,&target->dictionaries[j]->num_values,sizeof(unsigned int));
+            memcpy(*cursor + sizeof(unsigned int),target->dictionaries[j]->values,sizeof(long long) * target->dictionaries[j]->num_values);
+            *cursor += sizeof(unsigned int) + sizeof(long long) * target->dictionaries[j]->num_values;
+        }
+    unsigned char* data = *cursor;
+    for (i = 0; i < target->num_elements; i++, *cursor += size)
+        memcpy(*cursor,target->data_buffer + target->stride * i,size);
+    count_buffer_stat(target,bytes_copied,size * target->num_elements);
+    for (j = 0; j < target->num_types; j++)
+        if (target->types[j] == NESTED)
+            for (i = 0; i < target->num_elements; i++)
+            {
+                child = util_load_child(target,i,j);
+                memset(data + size * i + target->offsets[j],0,sizeof(buffer));
+                if (child == NULL)
+                    continue;
+                data[size * i + target->offsets[j]] = 1;
+                util_deep_dump(child,cursor);
+            }
+}
+
+void* dump_buffer_binary_deep(buffer target, unsigned int* size)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    unsigned int bin_size = util_deep_dump_size(target);
+    unsigned char* bin_data = malloc(bin_size), *cursor = bin_data;
+
+    util_deep_dump(target,&cursor);
+    if (size != NULL)
+        *size = bin_size;
+    return bin_data;
+}
+
+static enum construct_types* util_deep_read_header(const unsigned char** bin_data, unsigned int num_types, unsigned int* num_elements)
+{
+    enum construct_types* types = malloc(sizeof(enum construct_types) * num_types);
+    unsigned int j, word;
+    memcpy(num_elements,*bin_data + sizeof(unsigned int),sizeof(unsigned int));
+    *bin_data += 2 * sizeof(unsigned int);
+    for (j = 0; j < num_types; j++, *bin_data += sizeof(unsigned int))
+    {
+        memcpy(&word,*bin_data,sizeof(unsigned int));
+        #ifdef ERROR_CHECKING
+        error_if(word >= NUM_CONSTRUCT_TYPES,ERROR_INVALID_DATA);
+        #endif
+        types[j] = word;
+    }
+    return types;
+}
+
+static unsigned long util_deep_load_size(const unsigned char** bin_data, const unsigned char* end)
+{
+    unsigned int i, j, num_elements, num_types, encoded = 0, num_values;
+    #ifdef ERROR_CHECKING
+    error_if(end - *bin_data < (long)(2 * sizeof(unsigned int)),ERROR_INVALID_DATA);
+    #endif
+    memcpy(&num_types,*bin_data,sizeof(unsigned int));
+    #ifdef ERROR_CHECKING
+    error_if(num_types == 0 || (unsigned long)(end - *bin_data) < sizeof(unsigned int) * (2 + num_types),ERROR_INVALID_DATA);
+    #endif
+    if (num_types == 0)
+        return 0;
+    enum construct_types* types = util_deep_read_header(bin_data,num_types,&num_elements);
+
+    unsigned int* offsets = util_compute_offsets(num_types,types), size = offsets[num_types];
+    for (j = 0; j < num_types; j++)
+        if (util_is_encoded_type(types[j]))
+        {
+            #ifdef ERROR_CHECKING
+            error_if((unsigned long)(end - *bin_data) < sizeof(unsigned int),ERROR_INVALID_DATA);
+            #endif
+            memcpy(&num_values,*bin_data,sizeof(unsigned int));
+            *bin_data += sizeof(unsigned int) + sizeof(long long) * num_values;
+            encoded = 1;
+        }
+    #ifdef ERROR_CHECKING
+    error_if(*bin_data > end || (unsigned long)(end - *bin_data) < (unsigned long)size * num_elements,ERROR_INVALID_DATA);
+    #endif
+    const unsigned char* data = *bin_data;
+    unsigned long child, bytes = util_arena_node_bytes(num_types,num_elements,size,encoded);
+    *bin_data += (unsigned long)size * num_elements;
+    for (j = 0; j < num_types && bytes != 0; j++)
+        if (types[j] == NESTED)
+            for (i = 0; i < num_elements && bytes != 0; i++)
+                if (data[size * i + offsets[j]] != 0)
+                {
+                    child = util_deep_load_size(bin_data,end);
+                    bytes = child == 0 ? 0 : bytes + child;
+                }
+    free(offsets);
+    free(types);
+    return bytes;
+}
+
+static buffer util_deep_load(const unsigned char** bin_data, unsigned char** cursor, void* arena)
+{
+    unsigned int i, j, num_elements, num_types, encoded = 0, num_values;
+    memcpy(&num_types,*bin_data,sizeof(unsigned int));
+    if (num_types == 0)
+        return NULL;
+    enum construct_types* types = util_deep_read_header(bin_data,num_types,&num_elements);
+    for (j = 0; j < num_types; j++)
+        encoded |= util_is_encoded_type(types[j]);
+
+    buffer node = util_arena_node(cursor,arena,num_types,types,num_elements,encoded);
+    if (encoded)
+    {
+        struct buffer fresh;
+        fresh.num_types = num_types;
+        fresh.types = types;
+        util_create_dictionaries(&fresh);
+        memcpy(node->dictionaries,fresh.dictionaries,sizeof(struct construct_dictionary*) * num_types);
+        free(fresh.dictionaries);
+        for (j = 0; j < num_types; j++)
+            if (node->dictionaries[j] != NULL)
+            {
+                long long value;
+                memcpy(&num_values,*bin_data,sizeof(unsigned int));
+                *bin_data += sizeof(unsigned int);
+                for (i = 0; i < num_values; i++, *bin_data += sizeof(long long))
+                {
+                    memcpy(&value,*bin_data,sizeof(long long));
+                    util_encode(node->dictionaries[j],value);
+                }
+            }
+    }
+    memcpy(node->data_buffer,*bin_data,(unsigned long)node->stride * num_elements);
+    *bin_data += (unsigned long)node->stride * num_elements;
+    for (j = 0; j < num_types; j++)
+        if (types[j] == NESTED)
+            for (i = 0; i < num_elements; i++)
+                if (*(unsigned char*)get_buffer_field(node,i,j) != 0)
+                    util_store_child(node,i,j,util_deep_load(bin_data,cursor,arena));
+    free(types);
+    return node;
+}
+
+buffer load_buffer_binary_deep(void* bin_data, unsigned int size)
+{
+    #ifdef ERROR_CHECKING
+    error_if(bin_data == NULL,ERROR_INVALID_DATA);
+    #endif
+    const unsigned char* data = bin_data;
+    void* arena;
+    unsigned long bytes = util_deep_load_size(&data,data + size);
+    if (bytes == 0)
+        return NULL;
+    buffer root = util_arena_root(bytes,&arena);
+    unsigned char* cursor = (unsigned char*)root;
+
+    data = bin_data;
+    util_deep_load(&data,&cursor,arena);
+    register_arena(root);
+    return root;
+}
+
+void append_at(buffer src)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    unsigned int old_num_element = CURRENT_BUFFER->num_elements;
+    resize_buffer(CURRENT_BUFFER,CURRENT_BUFFER->num_elements + src->num_elements);
+    util_copy_elements(CURRENT_BUFFER,old_num_element,src,0,src->num_elements);
+}
+
+void append_to(buffer dest)
+{
+    #ifdef ERROR_CHECKING
+    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    unsigned int old_num_element = dest->num_elements;
+    resize_buffer(dest,dest->num_elements + CURRENT_BUFFER->num_elements);
+    util_copy_elements(dest,old_num_element,CURRENT_BUFFER,0,CURRENT_BUFFER->num_elements);
+}
+
+void append_buffer_at(buffer src, buffer dest)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    #endif
+    unsigned int old_num_element = dest->num_elements;
+    resize_buffer(dest,dest->num_elements + src->num_elements);
+    util_copy_elements(dest,old_num_element,src,0,src->num_elements);
+}
+
+void append_element_at(buffer src, unsigned int index)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    unsigned int old_num_element = CURRENT_BUFFER->num_elements;
+    resize_buffer(CURRENT_BUFFER,CURRENT_BUFFER->num_elements + 1);
+    util_copy_elements(CURRENT_BUFFER,old_num_element,src,index,1);
+}
+
+void append_element_to(buffer dest, unsigned int index)
+{
+    #ifdef ERROR_CHECKING
+    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    resize_buffer(dest,dest->num_elements + 1);
+    util_copy_elements(dest,dest->num_elements - 1,CURRENT_BUFFER,index,1);
+}
+
+void append_buffer_element_at(buffer src, unsigned int index, buffer dest)
+{
+    #ifdef ERROR_CHECKING
+    error_if(dest == NULL,ERROR_BAD_BUFFER);
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    #endif
+    resize_buffer(dest,dest->num_elements + 1);
+    util_copy_elements(dest,dest->num_elements - 1,src,index,1);
+}
+
+void flush_types()
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_TYPES == NULL,ERROR_NO_PUSHED_TYPES);
+    #endif
+    free(CURRENT_TYPES);
+    CURRENT_TYPES = NULL;
+    CURRENT_NUM_TYPES = 0;
+}
+
+void pop_types(unsigned int num_types)
+{
+    #ifdef ERROR_CHECKING
+    error_if(num_types < num_types,ERROR_INVALID_NUM_TYPES);
+    #endif
+    CURRENT_NUM_TYPES -= num_types;
+    CURRENT_TYPES = realloc(CURRENT_TYPES,CURRENT_NUM_TYPES * sizeof(enum construct_types));
+}
+
+void* dump_buffer_binary(buffer target, unsigned int* size)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+
+    struct buffer bin = *target;
+    bin.stride = util_get_size(target);
+    bin.data_buffer = malloc(bin.stride * target->num_elements);
+    util_copy_elements(&bin,0,target,0,target->num_elements);
+    count_buffer_stat(target,bytes_copied,bin.stride * target->num_elements);
+
+    if (size != NULL)
+        *size = bin.stride * target->num_elements;
+
+    return bin.data_buffer;
+}
+
+void load_buffer_binary(buffer target, void* bin_data, unsigned int size)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(bin_data == NULL,ERROR_INVALID_DATA);
+    #endif
+    util_prepare_write(target);
+    if (util_get_size(target) * target->num_elements != size)
+        resize_buffer(target,size / util_get_size(target));
+
+    struct buffer bin = *target;
+    bin.stride = util_get_size(target);
+    bin.data_buffer = bin_data;
+    util_copy_elements(target,0,&bin,0,target->num_elements);
+}
+
+void* dump_binary(unsigned int* size)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return dump_buffer_binary(CURRENT_BUFFER,size);
+}
+
+void load_binary(void* bin_data, unsigned int size)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    load_buffer_binary(CURRENT_BUFFER,bin_data,size);
+}
+
+buffer get_current_buffer()
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return CURRENT_BUFFER;
+}
+
+void reverse()
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    unsigned int i, num_elements = CURRENT_BUFFER->num_elements;
+
+    for (i = 0; i < num_elements; i++)
+        swap_buffer_at(CURRENT_BUFFER,num_elements - i - 1, i);
+}
+
+void reverse_buffer(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+
+    unsigned int i, num_elements = target->num_elements;
+    for (i = 0; i < num_elements; i++)
+        swap_buffer_at(target,num_elements - i - 1, i);
+}
+
+buffer recreate()
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return util_create_buffer_like(0,CURRENT_BUFFER);
+}
+
+
+buffer recreate_buffer(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+
+    return util_create_buffer_like(0,target);
+}
+
+void sort_by_field(unsigned int more,unsigned int field, enum construct_types type)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    count_stat(CURRENT_BUFFER,sorts,1);
+    int step,size = get_buffer_length(CURRENT_BUFFER);
+    for (step = 0; step < size - 1; ++step)
+    {
+        int i,swapped = 0;
+        for (i = 0; i < size - step - 1; ++i)
+        {
+            int condition = 0;
+
+            if (more)
+            {
+                switch(type)
+                {
+                    case UINT:
+                    condition = get_buffer_fieldui(CURRENT_BUFFER,i,field) > get_buffer_fieldui(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT:
+                    condition = get_buffer_fieldi(CURRENT_BUFFER,i,field) > get_buffer_fieldi(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case CHAR:
+                    condition = get_buffer_fieldc(CURRENT_BUFFER,i,field) > get_buffer_fieldc(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case UCHAR:
+                    condition = get_buffer_fielduc(CURRENT_BUFFER,i,field) > get_buffer_fielduc(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case FLOAT:
+                    condition = get_buffer_fieldf(CURRENT_BUFFER,i,field) > get_buffer_fieldf(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT8:
+                    condition = get_buffer_fieldi8(CURRENT_BUFFER,i,field) > get_buffer_fieldi8(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT16:
+                    condition = get_buffer_fieldi16(CURRENT_BUFFER,i,field) > get_buffer_fieldi16(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case UINT16:
+                    condition = get_buffer_fieldui16(CURRENT_BUFFER,i,field) > get_buffer_fieldui16(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT64:
+                    condition = get_buffer_fieldi64(CURRENT_BUFFER,i,field) > get_buffer_fieldi64(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case UINT64:
+                    condition = get_buffer_fieldui64(CURRENT_BUFFER,i,field) > get_buffer_fieldui64(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case DOUBLE:
+                    condition = get_buffer_fieldd(CURRENT_BUFFER,i,field) > get_buffer_fieldd(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case HALF:
+                    condition = get_buffer_fieldh(CURRENT_BUFFER,i,field) > get_buffer_fieldh(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case BIT:
+                    condition = get_buffer_fieldb(CURRENT_BUFFER,i,field) > get_buffer_fieldb(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case STR16:
+                    case STR32:
+                    condition = strcmp(get_buffer_fields(CURRENT_BUFFER,i,field),get_buffer_fields(CURRENT_BUFFER,i+1,field)) > 0;
+                    break;
+                    case STRING:
+                    condition = strcmp(get_buffer_fieldp(CURRENT_BUFFER,i,field),get_buffer_fieldp(CURRENT_BUFFER,i+1,field)) > 0;
+                    break;
+                    case DICT8:
+                    case DICT16:
+                    condition = get_buffer_fielde(CURRENT_BUFFER,i,field) > get_buffer_fielde(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case VOID:
+                    condition = get_buffer_fieldv(CURRENT_BUFFER,i,field) > get_buffer_fieldv(CURRENT_BUFFER,i+1,field);
+                    break;
+                    default:
+                    #ifdef ERROR_CHECKING
+                    error_if(0,ERROR_INVALID_TYPE);
+                    #endif
+                    break;
+                }
+            }
+            else
+            {
+                switch(type)
+                {
+                    case UINT:
+                    condition = get_buffer_fieldui(CURRENT_BUFFER,i,field) < get_buffer_fieldui(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT:
+                    condition = get_buffer_fieldi(CURRENT_BUFFER,i,field) < get_buffer_fieldi(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case CHAR:
+                    condition = get_buffer_fieldc(CURRENT_BUFFER,i,field) < get_buffer_fieldc(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case UCHAR:
+                    condition = get_buffer_fielduc(CURRENT_BUFFER,i,field) < get_buffer_fielduc(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case FLOAT:
+                    condition = get_buffer_fieldf(CURRENT_BUFFER,i,field) < get_buffer_fieldf(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT8:
+                    condition = get_buffer_fieldi8(CURRENT_BUFFER,i,field) < get_buffer_fieldi8(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT16:
+                    condition = get_buffer_fieldi16(CURRENT_BUFFER,i,field) < get_buffer_fieldi16(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case UINT16:
+                    condition = get_buffer_fieldui16(CURRENT_BUFFER,i,field) < get_buffer_fieldui16(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case INT64:
+                    condition = get_buffer_fieldi64(CURRENT_BUFFER,i,field) < get_buffer_fieldi64(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case UINT64:
+                    condition = get_buffer_fieldui64(CURRENT_BUFFER,i,field) < get_buffer_fieldui64(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case DOUBLE:
+                    condition = get_buffer_fieldd(CURRENT_BUFFER,i,field) < get_buffer_fieldd(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case HALF:
+                    condition = get_buffer_fieldh(CURRENT_BUFFER,i,field) < get_buffer_fieldh(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case BIT:
+                    condition = get_buffer_fieldb(CURRENT_BUFFER,i,field) < get_buffer_fieldb(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case STR16:
+                    case STR32:
+                    condition = strcmp(get_buffer_fields(CURRENT_BUFFER,i,field),get_buffer_fields(CURRENT_BUFFER,i+1,field)) < 0;
+                    break;
+                    case STRING:
+                    condition = strcmp(get_buffer_fieldp(CURRENT_BUFFER,i,field),get_buffer_fieldp(CURRENT_BUFFER,i+1,field)) < 0;
+                    break;
+                    case DICT8:
+                    case DICT16:
+                    condition = get_buffer_fielde(CURRENT_BUFFER,i,field) < get_buffer_fielde(CURRENT_BUFFER,i+1,field);
+                    break;
+                    case VOID:
+                    condition = get_buffer_fieldv(CURRENT_BUFFER,i,field) < get_buffer_fieldv(CURRENT_BUFFER,i+1,field);
+                    break;
+                    default:
+                    #ifdef ERROR_CHECKING
+                    error_if(0,ERROR_INVALID_TYPE);
+                    #endif
+                    break;
+                }
+            }
+
+            if (condition)
+            {
+                swap_buffer_at(CURRENT_BUFFER,i,i+1);
+                swapped = 1;
+            }
+        }
+        count_stat(CURRENT_BUFFER,comparisons,size - step - 1);
+        if (swapped == 0)
+        {
+            break;
+        }
+    }
+    if (more && type == CURRENT_BUFFER->types[field])
+        CURRENT_BUFFER->sorted_by = field + 1;
+}
+
+void sort_buffer_by_field(buffer target,unsigned int more,unsigned int field,enum construct_types type)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+
+    count_stat(target,sorts,1);
+    int step,size = get_buffer_length(target);
+    for (step = 0; step < size - 1; ++step)
+    {
+        int i,swapped = 0;
+        for (i = 0; i < size - step - 1; ++i)
+        {
+            int condition = 0;
+
+            if (more)
+            {
+                switch(type)
+                {
+                    case UINT:
+                    condition = get_buffer_fieldui(target,i,field) > get_buffer_fieldui(target,i+1,field);
+                    break;
+                    case INT:
+                    condition = get_buffer_fieldi(target,i,field) > get_buffer_fieldi(target,i+1,field);
+                    break;
+                    case CHAR:
+                    condition = get_buffer_fieldc(target,i,field) > get_buffer_fieldc(target,i+1,field);
+                    break;
+                    case UCHAR:
+                    condition = get_buffer_fielduc(target,i,field) > get_buffer_fielduc(target,i+1,field);
+                    break;
+                    case FLOAT:
+                    condition = get_buffer_fieldf(target,i,field) > get_buffer_fieldf(target,i+1,field);
+                    break;
+                    case INT8:
+                    condition = get_buffer_fieldi8(target,i,field) > get_buffer_fieldi8(target,i+1,field);
+                    break;
+                    case INT16:
+                    condition = get_buffer_fieldi16(target,i,field) > get_buffer_fieldi16(target,i+1,field);
+                    break;
+                    case UINT16:
+                    condition = get_buffer_fieldui16(target,i,field) > get_buffer_fieldui16(target,i+1,field);
+                    break;
+                    case INT64:
+                    condition = get_buffer_fieldi64(target,i,field) > get_buffer_fieldi64(target,i+1,field);
+                    break;
+                    case UINT64:
+                    condition = get_buffer_fieldui64(target,i,field) > get_buffer_fieldui64(target,i+1,field);
+                    break;
+                    case DOUBLE:
+                    condition = get_buffer_fieldd(target,i,field) > get_buffer_fieldd(target,i+1,field);
+                    break;
+                    case HALF:
+                    condition = get_buffer_fieldh(target,i,field) > get_buffer_fieldh(target,i+1,field);
+                    break;
+                    case BIT:
+                    condition = get_buffer_fieldb(target,i,field) > get_buffer_fieldb(target,i+1,field);
+                    break;
+                    case STR16:
+                    case STR32:
+                    condition = strcmp(get_buffer_fields(target,i,field),get_buffer_fields(target,i+1,field)) > 0;
+                    break;
+                    case STRING:
+                    condition = strcmp(get_buffer_fieldp(target,i,field),get_buffer_fieldp(target,i+1,field)) > 0;
+                    break;
+                    case DICT8:
+                    case DICT16:
+                    condition = get_buffer_fielde(target,i,field) > get_buffer_fielde(target,i+1,field);
+                    break;
+                    case VOID:
+                    condition = get_buffer_fieldv(target,i,field) > get_buffer_fieldv(target,i+1,field);
+                    break;
+                    default:
+                    #ifdef ERROR_CHECKING
+                    error_if(0,ERROR_INVALID_TYPE);
+                    #endif
+                    break;
+                }
+            }
+            else
+            {
+                switch(type)
+                {
+                    case UINT:
+                    condition = get_buffer_fieldui(target,i,field) < get_buffer_fieldui(target,i+1,field);
+                    break;
+                    case INT:
+                    condition = get_buffer_fieldi(target,i,field) < get_buffer_fieldi(target,i+1,field);
+                    break;
+                    case CHAR:
+                    condition = get_buffer_fieldc(target,i,field) < get_buffer_fieldc(target,i+1,field);
+                    break;
+                    case UCHAR:
+                    condition = get_buffer_fielduc(target,i,field) < get_buffer_fielduc(target,i+1,field);
+                    break;
+                    case FLOAT:
+                    condition = get_buffer_fieldf(target,i,field) < get_buffer_fieldf(target,i+1,field);
+                    break;
+                    case INT8:
+                    condition = get_buffer_fieldi8(target,i,field) < get_buffer_fieldi8(target,i+1,field);
+                    break;
+                    case INT16:
+                    condition = get_buffer_fieldi16(target,i,field) < get_buffer_fieldi16(target,i+1,field);
+                    break;
+                    case UINT16:
+                    condition = get_buffer_fieldui16(target,i,field) < get_buffer_fieldui16(target,i+1,field);
+                    break;
+                    case INT64:
+                    condition = get_buffer_fieldi64(target,i,field) < get_buffer_fieldi64(target,i+1,field);
+                    break;
+                    case UINT64:
+                    condition = get_buffer_fieldui64(target,i,field) < get_buffer_fieldui64(target,i+1,field);
+                    break;
+                    case DOUBLE:
+                    condition = get_buffer_fieldd(target,i,field) < get_buffer_fieldd(target,i+1,field);
+                    break;
+                    case HALF:
+                    condition = get_buffer_fieldh(target,i,field) < get_buffer_fieldh(target,i+1,field);
+                    break;
+                    case BIT:
+                    condition = get_buffer_fieldb(target,i,field) < get_buffer_fieldb(target,i+1,field);
+                    break;
+                    case STR16:
+                    case STR32:
+                    condition = strcmp(get_buffer_fields(target,i,field),get_buffer_fields(target,i+1,field)) < 0;
+                    break;
+                    case STRING:
+                    condition = strcmp(get_buffer_fieldp(target,i,field),get_buffer_fieldp(target,i+1,field)) < 0;
+                    break;
+                    case DICT8:
+                    case DICT16:
+                    condition = get_buffer_fielde(target,i,field) < get_buffer_fielde(target,i+1,field);
+                    break;
+                    case VOID:
+                    condition = get_buffer_fieldv(target,i,field) < get_buffer_fieldv(target,i+1,field);
+                    break;
+                    default:
+                    #ifdef ERROR_CHECKING
+                    error_if(0,ERROR_INVALID_TYPE);
+                    #endif
+                    break;
+                }
+            }
+
+            if (condition)
+            {
+                swap_buffer_at(target,i,i+1);
+                swapped = 1;
+            }
+        }
+        count_stat(target,comparisons,size - step - 1);
+        if (swapped == 0)
+        {
+            break;
+        }
+    }
+    if (more && type == target->types[field])
+        target->sorted_by = field + 1;
+}
+
+buffer copy_partial(unsigned int startidx, unsigned int endidx)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(startidx > endidx,ERROR_INVALID_INDEX);
+    error_if(endidx >= get_buffer_length(CURRENT_BUFFER),ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+
+    buffer copy = util_create_buffer_like(endidx - startidx,CURRENT_BUFFER);
+    copy->iterator = CURRENT_BUFFER->iterator;
+    copy->sorted_by = CURRENT_BUFFER->sorted_by;
+
+    util_copy_elements(copy,0,CURRENT_BUFFER,startidx,endidx - startidx);
+
+    return copy;
+}
+
+buffer copy_partial_buffer(buffer target, unsigned int startidx, unsigned int endidx)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(startidx > endidx,ERROR_INVALID_INDEX);
+    error_if(endidx >= get_buffer_length(target),ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+
+    buffer copy = util_create_buffer_like(endidx - startidx,target);
+    copy->iterator = target->iterator;
+    copy->sorted_by = target->sorted_by;
+
+    util_copy_elements(copy,0,target,startidx,endidx - startidx);
+
+    return copy;
+}
+
+buffer view_partial_buffer_strided(buffer target, unsigned int startidx, unsigned int num_elements, unsigned int step)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(step == 0,ERROR_INVALID_INDEX);
+    error_if(num_elements != 0 && startidx + (num_elements - 1) * step >= target->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+    unsigned int sorted_by = target->sorted_by;
+    util_prepare_write(target);
+    if (sorted_by != 0)
+        target->sorted_by = sorted_by;
+
+    buffer view = malloc(sizeof(struct buffer));
+    view->iterator = -1;
+    view->num_types = target->num_types;
+    view->types = target->types;
+    view->offsets = target->offsets;
+    view->dictionaries = target->dictionaries;
+    view->parent = target;
+    view->references = NULL;
+    view->arena = NULL;
+    view->sorted_by = sorted_by;
+    view->num_views = 0;
+    util_acquire_reference(util_get_root_buffer(target)->num_views);
+    view->stride = target->stride * step;
+    view->data_buffer = target->data_buffer + target->stride * startidx;
+    view->num_elements = num_elements;
+    memset(&view->stats,0,sizeof(struct construct_stats));
+    register_buffer(view);
+
+    return view;
+}
+
+buffer view_partial_buffer(buffer target, unsigned int startidx, unsigned int num_elements)
+{
+    return view_partial_buffer_strided(target,startidx,num_elements,1);
+}
+
+buffer view_partial(unsigned int startidx, unsigned int num_elements)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+
+    return view_partial_buffer_strided(CURRENT_BUFFER,startidx,num_elements,1);
+}
+
+void move_view(buffer view, unsigned int startidx, unsigned int num_elements)
+{
+    #ifdef ERROR_CHECKING
+    error_if(view == NULL,ERROR_BAD_BUFFER);
+    error_if(view->parent == NULL,ERROR_BAD_BUFFER);
+    error_if(num_elements != 0 && startidx + (num_elements - 1) * (view->stride / view->parent->stride) >= view->parent->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+
+    view->data_buffer = view->parent->data_buffer + view->parent->stride * startidx;
+    view->num_elements = num_elements;
+    view->iterator = -1;
+}
+
+unsigned int is_buffer_view(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+
+    return target->parent != NULL;
+}
+
+void open_buffer_cursor(cursor* target, buffer src, unsigned int num_fields, const enum construct_types* types)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_INVALID_DATA);
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(num_fields > src->num_types || num_fields > CONSTRUCT_MAX_CURSOR_FIELDS,ERROR_INVALID_NUM_TYPES);
+    #endif
+    unsigned int i;
+    #ifdef ERROR_CHECKING
+    for (i = 0; types != NULL && i < num_fields; i++)
+        error_if(types[i] != src->types[i],ERROR_INVALID_TYPE);
+    #else
+    (void)num_fields;
+    (void)types;
+    #endif
+    util_prepare_write(src);
+
+    for (i = 0; i < src->num_types && i < CONSTRUCT_MAX_CURSOR_FIELDS; i++)
+    {
+        target->offsets[i] = src->offsets[i];
+        if (src->types[i] == STR16 || src->types[i] == STR32)
+            target->masks[i] = src->types[i] == STR32 ? 32 : 16;
+        else
+            target->masks[i] = src->offsets[src->num_types + 1 + i];
+    }
+    target->num_fields = i;
+    target->data = src->data_buffer;
+    target->element = src->data_buffer;
+    target->stride = src->stride;
+    target->num_elements = src->num_elements;
+    target->index = -1;
+}
+
+void open_cursor(cursor* target, unsigned int num_fields, const enum construct_types* types)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    open_buffer_cursor(target,CURRENT_BUFFER,num_fields,types);
+}
+
+void begin_batch(batch* target, buffer src, unsigned int num_fields, const unsigned int* fields, const enum construct_types* types)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_INVALID_DATA);
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(num_fields > CONSTRUCT_MAX_CURSOR_FIELDS,ERROR_INVALID_NUM_TYPES);
+    error_if(num_fields != 0 && fields == NULL,ERROR_INVALID_DATA);
+    #endif
+    unsigned int i;
+    #ifdef ERROR_CHECKING
+    for (i = 0; i < num_fields; i++)
+    {
+        error_if(fields[i] >= src->num_types,ERROR_INVALID_FIELD);
+        error_if(types != NULL && types[i] != src->types[fields[i]],ERROR_INVALID_TYPE);
+    }
+    #else
+    (void)types;
+    #endif
+    util_prepare_write(src);
+
+    for (i = 0; i < num_fields; i++)
+    {
+        target->offsets[i] = src->offsets[fields[i]];
+        target->masks[i] = src->offsets[src->num_types + 1 + fields[i]];
+        target->types[i] = src->types[fields[i]];
+    }
+    target->num_fields = num_fields;
+    target->src = src;
+    target->src_data = &src->data_buffer;
+    target->src_num_elements = &src->num_elements;
+    target->src_references = &src->references;
+    target->data = src->data_buffer;
+    target->stride = src->stride;
+    target->num_elements = src->num_elements;
+    target->open = 1;
+}
+
+void end_batch(batch* target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_INVALID_DATA);
+    error_if(!is_batch_valid(target),ERROR_STALE_BATCH);
+    #endif
+    target->open = 0;
+}
+
+unsigned int is_batch_valid(const batch* target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_INVALID_DATA);
+    #endif
+    buffer root = target->src;
+    if (!target->open || root->data_buffer != target->data || root->num_elements != target->num_elements)
+        return 0;
+    root = util_get_root_buffer(root);
+    return root->references == NULL || util_load_references(*root->references) == 1;
+}
+
+void replace_inside_buffer(buffer target, unsigned int idxsrc, unsigned int idxdest)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(idxsrc >= target->num_elements || idxdest >= target->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+    util_prepare_write(target);
+
+    util_copy_elements(target,idxdest,target,idxsrc,1);
+}
+
+void replace_inside(unsigned int idxsrc, unsigned int idxdest)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    error_if(idxsrc >= CURRENT_BUFFER->num_elements || idxdest >= CURRENT_BUFFER->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+    util_prepare_write(CURRENT_BUFFER);
+
+    util_copy_elements(CURRENT_BUFFER,idxdest,CURRENT_BUFFER,idxsrc,1);
+}
+
+buffer init_bufferve(unsigned int num_elements, unsigned int num_types, enum construct_types* types)
+{
+    #ifdef ERROR_CHECKING
+    error_if(types == NULL,ERROR_BAD_TYPES);
+    #endif
+
+    enum construct_types* buffer_types = malloc(sizeof(enum construct_types) * num_types);
+    memcpy(buffer_types,types,sizeof(enum construct_types) * num_types);
+
+    return util_create_buffer(num_elements,num_types,buffer_types);
+
+}
+
+buffer init_bufferva(unsigned int num_elements, unsigned int num_types, ...)
+{
+    va_list types;
+    va_start(types,num_types);
+
+    enum construct_types* buffer_types = malloc(sizeof(enum construct_types) * num_types);
+    unsigned int i;
+    for (i = 0; i < num_types; i++)
+        buffer_types[i] = va_arg(types,enum construct_types);
+    va_end(types);
+
+    #ifdef ERROR_CHECKING
+    error_if(num_types == 0,ERROR_NO_PUSHED_TYPES);
+    #endif
+
+    return util_create_buffer(num_elements,num_types,buffer_types);
+}
+
+void* get_pointer(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field);
+}
+void* get_buffer_pointer(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field);
+}
+
+unsigned int* get_buffer_pointerui(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (unsigned int*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+unsigned int* get_pointerui(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (unsigned int*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+int* get_buffer_pointeri(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (int*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+int* get_pointeri(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (int*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+float* get_buffer_pointerf(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (float*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+float* get_pointerf(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (float*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+char* get_buffer_pointerc(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (char*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+char* get_pointerc(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (char*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+unsigned char* get_buffer_pointeruc(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (unsigned char*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+unsigned char* get_pointeruc(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (unsigned char*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+void** get_buffer_pointerv(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (void**)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+void** get_pointerv(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (void**)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+signed char* get_buffer_pointeri8(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (signed char*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+signed char* get_pointeri8(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (signed char*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+short* get_buffer_pointeri16(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (short*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+short* get_pointeri16(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (short*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+unsigned short* get_buffer_pointerui16(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (unsigned short*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+unsigned short* get_pointerui16(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (unsigned short*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+long long* get_buffer_pointeri64(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (long long*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+long long* get_pointeri64(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (long long*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+unsigned long long* get_buffer_pointerui64(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (unsigned long long*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+unsigned long long* get_pointerui64(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (unsigned long long*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+double* get_buffer_pointerd(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (double*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+double* get_pointerd(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (double*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+unsigned short* get_buffer_pointerh(buffer target, unsigned int element, unsigned int field)
+{
+    util_prepare_write(target);
+    return (unsigned short*)(target->data_buffer + get_buffer_element_data_offset(target,element) + util_get_size_until(target,field));
+}
+unsigned short* get_pointerh(unsigned int field)
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return (unsigned short*)(CURRENT_BUFFER->data_buffer + get_buffer_element_data_offset(CURRENT_BUFFER,CURRENT_BUFFER->iterator) + util_get_size_until(CURRENT_BUFFER,field));
+}
+
+void* get_element_pointer()
+{
+    util_prepare_write(CURRENT_BUFFER);
+    return CURRENT_BUFFER->data_buffer + get_element_data_offset(CURRENT_BUFFER->iterator);
+}
+
+void* get_buffer_element_pointer(buffer target, unsigned int element)
+{
+    util_prepare_write(target);
+    return target->data_buffer + get_buffer_element_data_offset(target,element);
+}
+
+
+void mul_field(unsigned int field, float factor)
+{
+    switch(CURRENT_BUFFER->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case INT:
+        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,(long long)(get_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * (double)factor));
+        break;
+        case UINT64:
+        set_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,(unsigned long long)(get_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * (double)factor));
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) * factor);
+        break;
+        case VOID:
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void div_field(unsigned int field, float factor)
+{
+    switch(CURRENT_BUFFER->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case INT:
+        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,(long long)(get_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / (double)factor));
+        break;
+        case UINT64:
+        set_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,(unsigned long long)(get_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / (double)factor));
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) / factor);
+        break;
+        case VOID:
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void add_field(unsigned int field, float factor)
+{
+    switch(CURRENT_BUFFER->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case INT:
+        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + (long long)factor);
+        break;
+        case UINT64:
+        set_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + (unsigned long long)factor);
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + factor);
+        break;
+        case VOID:
+        set_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) + (int)factor);
+        break;
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void sub_field(unsigned int field, float factor)
+{
+    switch(CURRENT_BUFFER->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case INT:
+        set_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fielduc(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldf(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi8(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui16(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldi64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - (long long)factor);
+        break;
+        case UINT64:
+        set_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldui64(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - (unsigned long long)factor);
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldd(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldh(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - factor);
+        break;
+        case VOID:
+        set_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field,get_buffer_fieldv(CURRENT_BUFFER,CURRENT_BUFFER->iterator,field) - (int)factor);
+        break;
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void mul_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
+{
+    switch(target->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) * factor);
+        break;
+        case INT:
+        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) * factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) * factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) * factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) * factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(target,element,field,get_buffer_fieldi8(target,element,field) * factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(target,element,field,get_buffer_fieldi16(target,element,field) * factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(target,element,field,get_buffer_fieldui16(target,element,field) * factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(target,element,field,(long long)(get_buffer_fieldi64(target,element,field) * (double)factor));
+        break;
+        case UINT64:
+        set_buffer_fieldui64(target,element,field,(unsigned long long)(get_buffer_fieldui64(target,element,field) * (double)factor));
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(target,element,field,get_buffer_fieldd(target,element,field) * (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(target,element,field,get_buffer_fieldh(target,element,field) * factor);
+        break;
+        case VOID:
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void div_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
+{
+    switch(target->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) / factor);
+        break;
+        case INT:
+        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) / factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) / factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) / factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) / factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(target,element,field,get_buffer_fieldi8(target,element,field) / factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(target,element,field,get_buffer_fieldi16(target,element,field) / factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(target,element,field,get_buffer_fieldui16(target,element,field) / factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(target,element,field,(long long)(get_buffer_fieldi64(target,element,field) / (double)factor));
+        break;
+        case UINT64:
+        set_buffer_fieldui64(target,element,field,(unsigned long long)(get_buffer_fieldui64(target,element,field) / (double)factor));
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(target,element,field,get_buffer_fieldd(target,element,field) / (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(target,element,field,get_buffer_fieldh(target,element,field) / factor);
+        break;
+        case VOID:
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void add_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
+{
+    switch(target->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) + factor);
+        break;
+        case INT:
+        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) + factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) + factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) + factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) + factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(target,element,field,get_buffer_fieldi8(target,element,field) + factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(target,element,field,get_buffer_fieldi16(target,element,field) + factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(target,element,field,get_buffer_fieldui16(target,element,field) + factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(target,element,field,get_buffer_fieldi64(target,element,field) + (long long)factor);
+        break;
+        case UINT64:
+        set_buffer_fieldui64(target,element,field,get_buffer_fieldui64(target,element,field) + (unsigned long long)factor);
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(target,element,field,get_buffer_fieldd(target,element,field) + (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(target,element,field,get_buffer_fieldh(target,element,field) + factor);
+        break;
+        case VOID:
+        set_buffer_fieldv(target,element,field,get_buffer_fieldv(target,element,field) + (int)factor);
+        break;
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void sub_buffer_field(buffer target, unsigned int element, unsigned int field, float factor)
+{
+    switch(target->types[field])
+    {
+        case UINT:
+        set_buffer_fieldui(target,element,field,get_buffer_fieldui(target,element,field) - factor);
+        break;
+        case INT:
+        set_buffer_fieldi(target,element,field,get_buffer_fieldi(target,element,field) - factor);
+        break;
+        case CHAR:
+        set_buffer_fieldc(target,element,field,get_buffer_fieldc(target,element,field) - factor);
+        break;
+        case UCHAR:
+        set_buffer_fielduc(target,element,field,get_buffer_fielduc(target,element,field) - factor);
+        break;
+        case FLOAT:
+        set_buffer_fieldf(target,element,field,get_buffer_fieldf(target,element,field) - factor);
+        break;
+        case INT8:
+        set_buffer_fieldi8(target,element,field,get_buffer_fieldi8(target,element,field) - factor);
+        break;
+        case INT16:
+        set_buffer_fieldi16(target,element,field,get_buffer_fieldi16(target,element,field) - factor);
+        break;
+        case UINT16:
+        set_buffer_fieldui16(target,element,field,get_buffer_fieldui16(target,element,field) - factor);
+        break;
+        case INT64:
+        set_buffer_fieldi64(target,element,field,get_buffer_fieldi64(target,element,field) - (long long)factor);
+        break;
+        case UINT64:
+        set_buffer_fieldui64(target,element,field,get_buffer_fieldui64(target,element,field) - (unsigned long long)factor);
+        break;
+        case DOUBLE:
+        set_buffer_fieldd(target,element,field,get_buffer_fieldd(target,element,field) - (double)factor);
+        break;
+        case HALF:
+        set_buffer_fieldh(target,element,field,get_buffer_fieldh(target,element,field) - factor);
+        break;
+        case VOID:
+        set_buffer_fieldv(target,element,field,get_buffer_fieldv(target,element,field) - (int)factor);
+        break;
+        default:
+        #ifdef ERROR_CHECKING
+        error_if(0,ERROR_INVALID_TYPE);
+        #endif
+        break;
+    }
+}
+
+void get_buffer_stats(buffer target, struct construct_stats* stats)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(stats == NULL,ERROR_INVALID_DATA);
+    #endif
+    #ifdef CONSTRUCT_STATS
+    stats->reallocs = util_atomic_load(target->stats.reallocs);
+    stats->bytes_copied = util_atomic_load(target->stats.bytes_copied);
+    stats->bytes_zeroed = util_atomic_load(target->stats.bytes_zeroed);
+    stats->sorts = util_atomic_load(target->stats.sorts);
+    stats->comparisons = util_atomic_load(target->stats.comparisons);
+    stats->swaps = util_atomic_load(target->stats.swaps);
+    #else
+    (void)target;
+    memset(stats,0,sizeof(struct construct_stats));
+    #endif
+}
+
+void get_global_stats(struct construct_stats* stats)
+{
+    #ifdef ERROR_CHECKING
+    error_if(stats == NULL,ERROR_INVALID_DATA);
+    #endif
+    #ifdef CONSTRUCT_STATS
+    stats->reallocs = util_atomic_load(GLOBAL_STATS.reallocs);
+    stats->bytes_copied = util_atomic_load(GLOBAL_STATS.bytes_copied);
+    stats->bytes_zeroed = util_atomic_load(GLOBAL_STATS.bytes_zeroed);
+    stats->sorts = util_atomic_load(GLOBAL_STATS.sorts);
+    stats->comparisons = util_atomic_load(GLOBAL_STATS.comparisons);
+    stats->swaps = util_atomic_load(GLOBAL_STATS.swaps);
+    #else
+    memset(stats,0,sizeof(struct construct_stats));
+    #endif
+}
+
+void reset_buffer_stats(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    #ifdef CONSTRUCT_STATS
+    util_atomic_store(target->stats.reallocs,0);
+    util_atomic_store(target->stats.bytes_copied,0);
+    util_atomic_store(target->stats.bytes_zeroed,0);
+    util_atomic_store(target->stats.sorts,0);
+    util_atomic_store(target->stats.comparisons,0);
+    util_atomic_store(target->stats.swaps,0);
+    #else
+    (void)target;
+    #endif
+}
+
+void reset_global_stats()
+{
+    #ifdef CONSTRUCT_STATS
+    util_atomic_store(GLOBAL_STATS.reallocs,0);
+    util_atomic_store(GLOBAL_STATS.bytes_copied,0);
+    util_atomic_store(GLOBAL_STATS.bytes_zeroed,0);
+    util_atomic_store(GLOBAL_STATS.sorts,0);
+    util_atomic_store(GLOBAL_STATS.comparisons,0);
+    util_atomic_store(GLOBAL_STATS.swaps,0);
+    #endif
+}
+
+unsigned int get_num_live_buffers()
+{
+    #ifdef CONSTRUCT_REGISTRY
+    unsigned int num_buffers;
+    util_lock_registry();
+    num_buffers = REGISTRY_NUM_BUFFERS;
+    util_unlock_registry();
+    return num_buffers;
+    #else
+    return 0;
+    #endif
+}
+
+unsigned long get_live_bytes(unsigned long* peak)
+{
+    #ifdef CONSTRUCT_REGISTRY
+    unsigned long bytes;
+    util_lock_registry();
+    if (peak != NULL)
+        *peak = REGISTRY_PEAK_BYTES;
+    bytes = REGISTRY_BYTES;
+    util_unlock_registry();
+    return bytes;
+    #else
+    if (peak != NULL)
+        *peak = 0;
+    return 0;
+    #endif
+}
+
+void for_each_live_buffer(void (*function)(buffer target, void* data), void* data)
+{
+    #ifdef ERROR_CHECKING
+    error_if(function == NULL,ERROR_INVALID_DATA);
+    #endif
+    #ifdef CONSTRUCT_REGISTRY
+    buffer target;
+    util_lock_registry();
+    for (target = REGISTRY; target != NULL; target = target->registry_next)
+        function(target,data);
+    util_unlock_registry();
+    #else
+    (void)function;
+    (void)data;
+    #endif
+}
+
+void get_buffer_footprint(buffer target, struct construct_footprint* footprint)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(footprint == NULL,ERROR_INVALID_DATA);
+    #endif
+    util_get_footprint(target,footprint);
+    #ifdef CONSTRUCT_REGISTRY
+    footprint->file = target->registry_file;
+    footprint->line = target->registry_line;
+    if (target->peak_bytes > footprint->peak_bytes)
+        footprint->peak_bytes = target->peak_bytes;
+    #endif
+}
+
+#ifdef CONSTRUCT_REGISTRY
+struct registry_entry
+{
+    buffer target;
+    struct construct_footprint footprint;
+    unsigned long bytes;
+};
+
+static int util_compare_registry_entries(const void* a, const void* b)
+{
+    unsigned long bytes_a = ((const struct registry_entry*)a)->bytes, bytes_b = ((const struct registry_entry*)b)->bytes;
+    return (bytes_a < bytes_b) - (bytes_a > bytes_b);
+}
+#endif
+
+void dump_registry_report(FILE* stream)
+{
+    #ifdef ERROR_CHECKING
+    error_if(stream == NULL,ERROR_INVALID_DATA);
+    #endif
+    #ifdef CONSTRUCT_REGISTRY
+    util_lock_registry();
+    struct registry_entry* entries = malloc(sizeof(struct registry_entry) * (REGISTRY_NUM_BUFFERS + 1));
+    unsigned int i, num_entries = 0;
+    buffer target;
+    for (target = REGISTRY; target != NULL; target = target->registry_next)
+    {
+        entries[num_entries].target = target;
+        get_buffer_footprint(target,&entries[num_entries].footprint);
+        entries[num_entries].bytes = entries[num_entries].footprint.header_bytes + entries[num_entries].footprint.type_bytes + entries[num_entries].footprint.data_bytes + entries[num_entries].footprint.slack_bytes;
+        num_entries++;
+    }
+    qsort(entries,num_entries,sizeof(struct registry_entry),util_compare_registry_entries);
+
+    fprintf(stream,"%u live buffers taking %lu bytes (peak %lu bytes)\n",REGISTRY_NUM_BUFFERS,REGISTRY_BYTES,REGISTRY_PEAK_BYTES);
+    for (i = 0; i < num_entries; i++)
+    {
+        struct construct_footprint* footprint = &entries[i].footprint;
+        fprintf(stream,"%10lu bytes (data %lu, types %lu, header %lu, slack %lu, peak %lu) %u elements%s%s created at %s:%u\n",
+            entries[i].bytes,footprint->data_bytes,footprint->type_bytes,footprint->header_bytes,footprint->slack_bytes,footprint->peak_bytes,
+            entries[i].target->num_elements,entries[i].target->parent != NULL ? ", view" : "",entries[i].target->references != NULL ? ", shared" : "",
+            footprint->file != NULL ? footprint->file : "unknown",footprint->line);
+    }
+    util_unlock_registry();
+    free(entries);
+    #else
+    fprintf(stream,"Construct was compiled without \"CONSTRUCT_REGISTRY\", no buffers are tracked\n");
+    #endif
+}
+
+void set_registry_call_site(const char* file, unsigned int line)
+{
+    #ifdef CONSTRUCT_REGISTRY
+    REGISTRY_FILE = file;
+    REGISTRY_LINE = line;
+    #else
+    (void)file;
+    (void)line;
+    #endif
+}
+
+#ifdef CONSTRUCT_PROFILE
+static int util_compare_profile_sites(const void* a, const void* b)
+{
+    double time_a = ((const struct profile_site*)a)->nanoseconds, time_b = ((const struct profile_site*)b)->nanoseconds;
+    return (time_a < time_b) - (time_a > time_b);
+}
+#endif
+
+void dump_allocation_report(FILE* stream, unsigned int num_sites)
+{
+    #ifdef ERROR_CHECKING
+    error_if(stream == NULL,ERROR_INVALID_DATA);
+    #endif
+    #ifdef CONSTRUCT_PROFILE
+    struct profile_site sites[CONSTRUCT_PROFILE_SITES + 1];
+    unsigned int i, num_used = 0;
+    unsigned long num_blocks;
+    util_lock_allocations();
+    for (i = 0; i < CONSTRUCT_PROFILE_SITES; i++)
+        if (PROFILE_SITES[i].function != NULL)
+            sites[num_used++] = PROFILE_SITES[i];
+    if (PROFILE_OVERFLOW.function != NULL)
+        sites[num_used++] = PROFILE_OVERFLOW;
+    num_blocks = PROFILE_NUM_BLOCKS;
+    util_unlock_allocations();
+    qsort(sites,num_used,sizeof(struct profile_site),util_compare_profile_sites);
+
+    if (num_sites == 0 || num_sites > num_used)
+        num_sites = num_used;
+    fprintf(stream,"%u of %u allocating call sites, %lu blocks live\n",num_sites,num_used,num_blocks);
+    for (i = 0; i < num_sites; i++)
+        fprintf(stream,"%12.0f ns %8lu mallocs %8lu reallocs (longest chain %lu, grown %lu bytes) %8lu frees %12lu bytes in %s (%s:%u)\n",
+            sites[i].nanoseconds,sites[i].allocations,sites[i].reallocs,sites[i].longest_chain,sites[i].grown_bytes,
+            sites[i].frees,sites[i].bytes,sites[i].function,sites[i].file,sites[i].line);
+    #else
+    (void)num_sites;
+    fprintf(stream,"Construct was compiled without \"CONSTRUCT_PROFILE\", no allocations are profiled\n");
+    #endif
+}
+
+void reset_allocation_profile()
+{
+    #ifdef CONSTRUCT_PROFILE
+    util_lock_allocations();
+    memset(PROFILE_SITES,0,sizeof(PROFILE_SITES));
+    memset(&PROFILE_OVERFLOW,0,sizeof(PROFILE_OVERFLOW));
+    util_unlock_allocations();
+    #endif
+}
+
+#ifdef CONSTRUCT_THREADS
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+typedef void (*util_task)(void* data, unsigned int index);
+
+/* Elements per block of parallel_for_buffer() if no grain is given */
+#ifndef CONSTRUCT_PARALLEL_GRAIN
+    #define CONSTRUCT_PARALLEL_GRAIN 16384
+#endif
+
+#ifdef CONSTRUCT_THREADS
+struct scheduler_task
+{
+    construct_task_function function;
+    buffer target;
+    unsigned int start,count;
+    void* user;
+    struct construct_task_group* group;
+};
+
+struct task_deque
+{
+    pthread_mutex_t lock;
+    struct scheduler_task* tasks;
+    unsigned int top,bottom,capacity;
+    unsigned char padding[64];
+};
+
+struct thread_pool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t* threads;
+    struct task_deque* deques;
+    unsigned int num_threads,num_deques,queued,sleeping,stop;
+};
+
+static struct thread_pool THREAD_POOL = {PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER,NULL,NULL,1,0,0,0,0};
+static pthread_mutex_t THREAD_POOL_INIT = PTHREAD_MUTEX_INITIALIZER;
+static __thread unsigned int THREAD_INDEX = 0, THREAD_SEED = 0x2545f491u;
+
+static void util_deque_push(struct task_deque* deque, const struct scheduler_task* task)
+{
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top == deque->capacity)
+    {
+        unsigned int i, capacity = deque->capacity == 0 ? 64 : deque->capacity * 2;
+        struct scheduler_task* tasks = malloc(sizeof(struct scheduler_task) * capacity);
+        for (i = deque->top; i != deque->bottom; i++)
+            tasks[i & (capacity - 1)] = deque->tasks[i & (deque->capacity - 1)];
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+    }
+    deque->tasks[deque->bottom & (deque->capacity - 1)] = *task;
+    __atomic_store_n(&deque->bottom,deque->bottom + 1,__ATOMIC_RELAXED);
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static unsigned int util_deque_take(struct task_deque* deque, struct scheduler_task* task, unsigned int steal)
+{
+    unsigned int found = 0;
+    if (__atomic_load_n(&deque->top,__ATOMIC_RELAXED) == __atomic_load_n(&deque->bottom,__ATOMIC_RELAXED))
+        return 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->top != deque->bottom)
+    {
+        if (steal)
+        {
+            *task = deque->tasks[deque->top & (deque->capacity - 1)];
+            __atomic_store_n(&deque->top,deque->top + 1,__ATOMIC_RELAXED);
+        }
+        else
+        {
+            __atomic_store_n(&deque->bottom,deque->bottom - 1,__ATOMIC_RELAXED);
+            *task = deque->tasks[deque->bottom & (deque->capacity - 1)];
+        }
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static unsigned int util_find_task(struct scheduler_task* task)
+{
+    unsigned int i, victim, found = util_deque_take(&THREAD_POOL.deques[THREAD_INDEX],task,0);
+    THREAD_SEED ^= THREAD_SEED << 13;
+    THREAD_SEED ^= THREAD_SEED >> 17;
+    THREAD_SEED ^= THREAD_SEED << 5;
+    victim = THREAD_SEED % THREAD_POOL.num_deques;
+    for (i = 0; !found && i < THREAD_POOL.num_deques; i++, victim = victim + 1 == THREAD_POOL.num_deques ? 0 : victim + 1)
+        if (victim != THREAD_INDEX)
+            found = util_deque_take(&THREAD_POOL.deques[victim],task,1);
+    if (found)
+        __atomic_fetch_sub(&THREAD_POOL.queued,1,__ATOMIC_SEQ_CST);
+    return found;
+}
+
+static void util_execute_task(struct scheduler_task* task)
+{
+    task->function(task->target,task->start,task->count,task->user);
+    __atomic_fetch_sub(&task->group->pending,1,__ATOMIC_RELEASE);
+}
+
+static void* util_pool_worker(void* argument)
+{
+    struct scheduler_task task;
+    unsigned int stop = 0;
+    THREAD_INDEX = (unsigned int)(unsigned long)argument;
+    THREAD_SEED = THREAD_INDEX * 2654435761u | 1;
+    while (!stop)
+    {
+        if (util_find_task(&task))
+        {
+            util_execute_task(&task);
+            continue;
+        }
+        pthread_mutex_lock(&THREAD_POOL.lock);
+        __atomic_fetch_add(&THREAD_POOL.sleeping,1,__ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&THREAD_POOL.queued,__ATOMIC_SEQ_CST) == 0 && !THREAD_POOL.stop)
+            pthread_cond_wait(&THREAD_POOL.wake,&THREAD_POOL.lock);
+        __atomic_fetch_sub(&THREAD_POOL.sleeping,1,__ATOMIC_SEQ_CST);
+        stop = THREAD_POOL.stop;
+        pthread_mutex_unlock(&THREAD_POOL.lock);
+    }
+    return NULL;
+}
+#endif
+
+#ifdef CONSTRUCT_THREADS
+static void util_deinit_thread_pool()
+{
+    unsigned int i;
+    if (THREAD_POOL.deques == NULL)
+        return;
+    pthread_mutex_lock(&THREAD_POOL.lock);
+    THREAD_POOL.stop = 1;
+    pthread_cond_broadcast(&THREAD_POOL.wake);
+    pthread_mutex_unlock(&THREAD_POOL.lock);
+    for (i = 0; i + 1 < THREAD_POOL.num_threads; i++)
+        pthread_join(THREAD_POOL.threads[i],NULL);
+    for (i = 0; i < THREAD_POOL.num_deques; i++)
+    {
+        pthread_mutex_destroy(&THREAD_POOL.deques[i].lock);
+        free(THREAD_POOL.deques[i].tasks);
+    }
+    free(THREAD_POOL.deques);
+    free(THREAD_POOL.threads);
+    THREAD_POOL.deques = NULL;
+    THREAD_POOL.threads = NULL;
+    __atomic_store_n(&THREAD_POOL.num_threads,1,__ATOMIC_RELAXED);
+    THREAD_POOL.num_deques = 0;
+    THREAD_POOL.queued = 0;
+    THREAD_POOL.stop = 0;
+}
+
+/* Callers hold THREAD_POOL_INIT, so the pool is never set up or torn down twice at once */
+static void util_init_thread_pool(unsigned int num_threads)
+{
+    unsigned int i;
+    pthread_t* threads;
+    util_deinit_thread_pool();
+    if (num_threads == 0)
+        num_threads = 1;
+    /* The calling thread is the first thread of the pool, so only the others need an entry (If it can't be allocated, the pool runs on the calling thread alone) */
+    threads = malloc(sizeof(pthread_t) * (num_threads > 1 ? num_threads - 1 : 1));
+    if (threads == NULL)
+        num_threads = 1;
+    THREAD_POOL.num_deques = num_threads;
+    THREAD_POOL.deques = malloc(sizeof(struct task_deque) * THREAD_POOL.num_deques);
+    memset(THREAD_POOL.deques,0,sizeof(struct task_deque) * THREAD_POOL.num_deques);
+    for (i = 0; i < THREAD_POOL.num_deques; i++)
+        pthread_mutex_init(&THREAD_POOL.deques[i].lock,NULL);
+    for (i = 1; i < num_threads; i++)
+        if (pthread_create(&threads[THREAD_POOL.num_threads - 1],NULL,util_pool_worker,(void*)(unsigned long)THREAD_POOL.num_threads) == 0)
+            __atomic_store_n(&THREAD_POOL.num_threads,THREAD_POOL.num_threads + 1,__ATOMIC_RELAXED);
+    __atomic_store_n(&THREAD_POOL.threads,threads,__ATOMIC_RELEASE);
+}
+#endif
+
+void init_thread_pool(unsigned int num_threads)
+{
+    #ifdef CONSTRUCT_THREADS
+    pthread_mutex_lock(&THREAD_POOL_INIT);
+    util_init_thread_pool(num_threads);
+    pthread_mutex_unlock(&THREAD_POOL_INIT);
+    #else
+    (void)num_threads;
+    #endif
+}
+
+void deinit_thread_pool()
+{
+    #ifdef CONSTRUCT_THREADS
+    pthread_mutex_lock(&THREAD_POOL_INIT);
+    util_deinit_thread_pool();
+    pthread_mutex_unlock(&THREAD_POOL_INIT);
+    #endif
+}
+
+unsigned int get_thread_pool_size()
+{
+    #ifdef CONSTRUCT_THREADS
+    if (__atomic_load_n(&THREAD_POOL.threads,__ATOMIC_ACQUIRE) == NULL)
+    {
+        pthread_mutex_lock(&THREAD_POOL_INIT);
+        if (THREAD_POOL.threads == NULL)
+        {
+            long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+            util_init_thread_pool(num_threads > 0 ? (unsigned int)num_threads : 1);
+        }
+        pthread_mutex_unlock(&THREAD_POOL_INIT);
+    }
+    return __atomic_load_n(&THREAD_POOL.num_threads,__ATOMIC_RELAXED);
+    #else
+    return 1;
+    #endif
+}
+
+void construct_spawn(struct construct_task_group* group, construct_task_function function, buffer target, unsigned int start, unsigned int count, void* user)
+{
+    #ifdef ERROR_CHECKING
+    error_if(group == NULL || function == NULL,ERROR_INVALID_DATA);
+    #endif
+    #ifdef CONSTRUCT_THREADS
+    if (get_thread_pool_size() > 1)
+    {
+        struct scheduler_task task;
+        task.function = function;
+        task.target = target;
+        task.start = start;
+        task.count = count;
+        task.user = user;
+        task.group = group;
+        __atomic_fetch_add(&group->pending,1,__ATOMIC_RELAXED);
+        __atomic_fetch_add(&THREAD_POOL.queued,1,__ATOMIC_SEQ_CST);
+        util_deque_push(&THREAD_POOL.deques[THREAD_INDEX],&task);
+        if (__atomic_load_n(&THREAD_POOL.sleeping,__ATOMIC_SEQ_CST) != 0)
+        {
+            pthread_mutex_lock(&THREAD_POOL.lock);
+            pthread_cond_signal(&THREAD_POOL.wake);
+            pthread_mutex_unlock(&THREAD_POOL.lock);
+        }
+        return;
+    }
+    #endif
+    (void)group;
+    function(target,start,count,user);
+}
+
+void construct_sync(struct construct_task_group* group)
+{
+    #ifdef ERROR_CHECKING
+    error_if(group == NULL,ERROR_INVALID_DATA);
+    #endif
+    #ifdef CONSTRUCT_THREADS
+    struct scheduler_task task;
+    while (__atomic_load_n(&group->pending,__ATOMIC_ACQUIRE) != 0)
+    {
+        if (util_find_task(&task))
+            util_execute_task(&task);
+        else
+            sched_yield();
+    }
+    #else
+    (void)group;
+    #endif
+}
+
+struct parallel_range
+{
+    util_task task;
+    void* data;
+    struct construct_task_group group;
+};
+
+static void util_run_range(buffer target, unsigned int start, unsigned int count, void* user)
+{
+    struct parallel_range* range = user;
+    (void)target;
+    while (count > 1)
+    {
+        construct_spawn(&range->group,util_run_range,NULL,start + count / 2,count - count / 2,user);
+        count /= 2;
+    }
+    range->task(range->data,start);
+}
+
+void util_run_parallel(unsigned int num_tasks, util_task task, void* data)
+{
+    struct parallel_range range;
+    unsigned int i;
+    if (num_tasks < 2 || get_thread_pool_size() == 1)
+    {
+        for (i = 0; i < num_tasks; i++)
+            task(data,i);
+        return;
+    }
+    range.task = task;
+    range.data = data;
+    range.group.pending = 0;
+    util_run_range(NULL,0,num_tasks,&range);
+    construct_sync(&range.group);
+}
+
+struct parallel_for_job
+{
+    buffer target;
+    construct_range_function function;
+    unsigned int grain;
+    void* user;
+};
+
+static void util_parallel_for_block(void* data, unsigned int index)
+{
+    struct parallel_for_job* job = data;
+    unsigned int start = index * job->grain;
+    unsigned int count = job->target->num_elements - start < job->grain ? job->target->num_elements - start : job->grain;
+    job->function((unsigned char*)job->target->data_buffer + (unsigned long)job->target->stride * start,start,count,job->target->stride,job->user);
+}
+
+void parallel_for_buffer(buffer target, construct_range_function function, unsigned int grain, void* user)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(function == NULL,ERROR_INVALID_DATA);
+    #endif
+    struct parallel_for_job job;
+    if (target->num_elements == 0)
+        return;
+    util_prepare_write(target);
+    job.target = target;
+    job.function = function;
+    job.grain = grain == 0 ? CONSTRUCT_PARALLEL_GRAIN : grain;
+    job.user = user;
+    util_run_parallel((target->num_elements - 1) / job.grain + 1,util_parallel_for_block,&job);
+}
+
+void parallel_for(construct_range_function function, unsigned int grain, void* user)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    parallel_for_buffer(CURRENT_BUFFER,function,grain,user);
+}
+
+unsigned int util_hash_bytes(const unsigned char* data, unsigned int size)
+{
+    unsigned long long hash = 0x9e3779b97f4a7c15ull ^ size, word;
+    for (; size >= sizeof(word); size -= sizeof(word), data += sizeof(word))
+    {
+        memcpy(&word,data,sizeof(word));
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+    if (size != 0)
+    {
+        word = 0;
+        memcpy(&word,data,size);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    return (unsigned int)(hash >> 32);
+}
+
+unsigned int util_key_size(buffer src, unsigned int num_keys, const unsigned int* key_fields)
+{
+    unsigned int i, size = 0;
+    for (i = 0; i < num_keys; i++)
+        size += src->types[key_fields[i]] == BIT ? 1 : sizes[src->types[key_fields[i]]];
+    return size;
+}
+
+/* Gives a floating point key one representation per value (0.0 for -0.0 and a single NaN for all of them), so that keys can be hashed and compared bytewise */
+static void util_normalize_key(enum construct_types type, unsigned char* key)
+{
+    float float_value;
+    double double_value;
+    unsigned short half_value;
+    unsigned int float_nan = 0x7fc00000u;
+    unsigned long long double_nan = 0x7ff8000000000000ull;
+    switch (type)
+    {
+        case FLOAT:
+        memcpy(&float_value,key,sizeof(float));
+        if (float_value != float_value)
+            memcpy(key,&float_nan,sizeof(float));
+        else if (float_value == 0.0f)
+            memset(key,0,sizeof(float));
+        break;
+        case DOUBLE:
+        memcpy(&double_value,key,sizeof(double));
+        if (double_value != double_value)
+            memcpy(key,&double_nan,sizeof(double));
+        else if (double_value == 0.0)
+            memset(key,0,sizeof(double));
+        break;
+        case HALF:
+        memcpy(&half_value,key,sizeof(unsigned short));
+        if ((half_value & 0x7c00) == 0x7c00 && (half_value & 0x03ff) != 0)
+            half_value = 0x7e00;
+        else if (half_value == 0x8000)
+            half_value = 0;
+        memcpy(key,&half_value,sizeof(unsigned short));
+        break;
+        default:
+        break;
+    }
+}
+
+void util_load_key(buffer src, unsigned int element, unsigned int num_keys, const unsigned int* key_fields, unsigned char* key)
+{
+    const unsigned char* data = (const unsigned char*)src->data_buffer + src->stride * element;
+    unsigned int i;
+    for (i = 0; i < num_keys; i++)
+    {
+        if (src->types[key_fields[i]] == BIT)
+            *key++ = (data[src->offsets[key_fields[i]]] & src->offsets[src->num_types + 1 + key_fields[i]]) != 0;
+        else
+        {
+            memcpy(key,data + src->offsets[key_fields[i]],sizes[src->types[key_fields[i]]]);
+            util_normalize_key(src->types[key_fields[i]],key);
+            key += sizes[src->types[key_fields[i]]];
+        }
+    }
+}
+
+void util_store_key(buffer dest, unsigned int element, unsigned int first_field, unsigned int num_keys, const unsigned char* key)
+{
+    unsigned char* data = (unsigned char*)dest->data_buffer + dest->stride * element;
+    unsigned int i;
+    for (i = first_field; i < first_field + num_keys; i++)
+    {
+        if (dest->types[i] == BIT)
+            set_bit_field(data + dest->offsets[i],dest->offsets[dest->num_types + 1 + i],*key++);
+        else
+        {
+            memcpy(data + dest->offsets[i],key,sizes[dest->types[i]]);
+            key += sizes[dest->types[i]];
+        }
+    }
+}
+
+void util_load_values(buffer src, unsigned int field, unsigned int index, unsigned int num_values, double* values)
+{
+    const unsigned char* data = (const unsigned char*)src->data_buffer + src->stride * index + src->offsets[field];
+    unsigned int i;
+    if (src->types[field] == BIT)
+    {
+        for (i = 0; i < num_values; i++)
+            values[i] = (data[src->stride * i] & src->offsets[src->num_types + 1 + field]) != 0;
+    }
+    else if (util_is_encoded_type(src->types[field]))
+    {
+        long long codes[CONSTRUCT_CONVERT_CHUNK];
+        util_load_integers(src->types[field],data,src->stride,num_values,codes);
+        for (i = 0; i < num_values; i++)
+            values[i] = (double)src->dictionaries[field]->values[codes[i]];
+    }
+    else
+        util_load_reals(src->types[field],data,src->stride,num_values,values);
+}
+
+void util_share_field_dictionary(buffer dest, unsigned int dest_field, buffer src, unsigned int src_field)
+{
+    if (!util_is_encoded_type(src->types[src_field]))
+        return;
+    util_release_dictionary(dest->dictionaries[dest_field]);
+    dest->dictionaries[dest_field] = src->dictionaries[src_field];
+    dest->dictionaries[dest_field]->references++;
+}
+
+struct group_table
+{
+    unsigned int num_groups,capacity,table_size,key_size,num_aggregates;
+    unsigned int* table;
+    unsigned int* hashes;
+    unsigned char* keys;
+    unsigned long long* counts;
+    double* values;
+};
+
+struct group_job
+{
+    buffer src;
+    unsigned int num_keys,num_aggregates,num_partitions;
+    const unsigned int* key_fields;
+    const struct construct_aggregate* aggregates;
+    struct group_table* locals;
+    struct group_table* partitions;
+};
+
+static void util_group_init(struct group_table* groups, unsigned int key_size, unsigned int num_aggregates)
+{
+    memset(groups,0,sizeof(struct group_table));
+    groups->key_size = key_size;
+    groups->num_aggregates = num_aggregates;
+}
+
+static void util_group_free(struct group_table* groups)
+{
+    free(groups->table);
+    free(groups->hashes);
+    free(groups->keys);
+    free(groups->counts);
+    free(groups->values);
+}
+
+static void util_group_grow(struct group_table* groups)
+{
+    unsigned int i, slot;
+    groups->capacity = groups->capacity == 0 ? 64 : groups->capacity * 2;
+    groups->hashes = realloc(groups->hashes,sizeof(unsigned int) * groups->capacity);
+    groups->keys = realloc(groups->keys,(unsigned long)groups->key_size * groups->capacity);
+    groups->counts = realloc(groups->counts,sizeof(unsigned long long) * groups->capacity);
+    if (groups->num_aggregates != 0)
+        groups->values = realloc(groups->values,sizeof(double) * groups->num_aggregates * groups->capacity);
+    free(groups->table);
+    groups->table_size = groups->capacity * 2;
+    groups->table = malloc(sizeof(unsigned int) * groups->table_size);
+    memset(groups->table,0,sizeof(unsigned int) * groups->table_size);
+    for (i = 0; i < groups->num_groups; i++)
+    {
+        for (slot = groups->hashes[i] & (groups->table_size - 1); groups->table[slot] != 0; slot = (slot + 1) & (groups->table_size - 1))
+            ;
+        groups->table[slot] = i + 1;
+    }
+}
+
+static unsigned int util_group_find(struct group_table* groups, const unsigned char* key, unsigned int hash, unsigned int* added)
+{
+    unsigned int slot, group;
+    if (groups->num_groups == groups->capacity)
+        util_group_grow(groups);
+    for (slot = hash & (groups->table_size - 1); groups->table[slot] != 0; slot = (slot + 1) & (groups->table_size - 1))
+    {
+        group = groups->table[slot] - 1;
+        if (groups->hashes[group] == hash && memcmp(groups->keys + (unsigned long)groups->key_size * group,key,groups->key_size) == 0)
+        {
+            *added = 0;
+            return group;
+        }
+    }
+    group = groups->num_groups++;
+    groups->table[slot] = group + 1;
+    groups->hashes[group] = hash;
+    memcpy(groups->keys + (unsigned long)groups->key_size * group,key,groups->key_size);
+    groups->counts[group] = 0;
+    *added = 1;
+    return group;
+}
+
+static void util_group_accumulate(struct group_table* groups, unsigned int group, unsigned int added, const struct construct_aggregate* aggregates, const double* values, unsigned long long count)
+{
+    double* accumulators = groups->values + (unsigned long)groups->num_aggregates * group;
+    unsigned int i;
+    groups->counts[group] += count;
+    for (i = 0; i < groups->num_aggregates; i++)
+        switch (aggregates[i].op)
+        {
+            case AGGREGATE_SUM:
+            case AGGREGATE_MEAN:
+            accumulators[i] = added ? values[i] : accumulators[i] + values[i];
+            break;
+            case AGGREGATE_MIN:
+            accumulators[i] = added || values[i] < accumulators[i] ? values[i] : accumulators[i];
+            break;
+            case AGGREGATE_MAX:
+            accumulators[i] = added || values[i] > accumulators[i] ? values[i] : accumulators[i];
+            break;
+            default:
+            break;
+        }
+}
+
+static void util_group_range(void* data, unsigned int index)
+{
+    struct group_job* job = data;
+    struct group_table* groups = job->locals + index;
+    buffer src = job->src;
+    unsigned int start = (unsigned long)src->num_elements * index / job->num_partitions;
+    unsigned int end = (unsigned long)src->num_elements * (index + 1) / job->num_partitions;
+    unsigned int i, j, num_values, group, added;
+    unsigned char* key = malloc(groups->key_size + 1);
+    double* chunk = malloc(sizeof(double) * CONSTRUCT_CONVERT_CHUNK * job->num_aggregates + 1);
+    double* values = malloc(sizeof(double) * job->num_aggregates + 1);
+
+    for (i = start; i < end; i += num_values)
+    {
+        num_values = end - i < CONSTRUCT_CONVERT_CHUNK ? end - i : CONSTRUCT_CONVERT_CHUNK;
+        for (j = 0; j < job->num_aggregates; j++)
+            if (job->aggregates[j].op != AGGREGATE_COUNT)
+                util_load_values(src,job->aggregates[j].field,i,num_values,chunk + CONSTRUCT_CONVERT_CHUNK * j);
+        unsigned int k;
+        for (k = 0; k < num_values; k++)
+        {
+            util_load_key(src,i + k,job->num_keys,job->key_fields,key);
+            group = util_group_find(groups,key,util_hash_bytes(key,groups->key_size),&added);
+            for (j = 0; j < job->num_aggregates; j++)
+                values[j] = chunk[CONSTRUCT_CONVERT_CHUNK * j + k];
+            util_group_accumulate(groups,group,added,job->aggregates,values,1);
+        }
+    }
+    free(key);
+    free(chunk);
+    free(values);
+}
+
+static void util_group_merge(void* data, unsigned int index)
+{
+    struct group_job* job = data;
+    struct group_table* groups = job->partitions + index;
+    unsigned int i, local, group, added;
+    for (local = 0; local < job->num_partitions; local++)
+    {
+        struct group_table* partial = job->locals + local;
+        for (i = 0; i < partial->num_groups; i++)
+        {
+            if (((unsigned long long)partial->hashes[i] * job->num_partitions) >> 32 != index)
+                continue;
+            group = util_group_find(groups,partial->keys + (unsigned long)partial->key_size * i,partial->hashes[i],&added);
+            util_group_accumulate(groups,group,added,job->aggregates,partial->values + (unsigned long)partial->num_aggregates * i,partial->counts[i]);
+        }
+    }
+}
+
+buffer group_buffer_by(buffer src, unsigned int num_keys, const unsigned int* key_fields, unsigned int num_aggregates, const struct construct_aggregate* aggregates, unsigned int num_threads)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(num_keys == 0 || key_fields == NULL || (num_aggregates != 0 && aggregates == NULL),ERROR_INVALID_DATA);
+    #endif
+    unsigned int i, j, num_groups = 0;
+    #ifdef ERROR_CHECKING
+    for (i = 0; i < num_keys; i++)
+        error_if(key_fields[i] >= src->num_types,ERROR_INVALID_FIELD);
+    for (i = 0; i < num_aggregates; i++)
+    {
+        error_if(aggregates[i].op > AGGREGATE_MEAN,ERROR_INVALID_DATA);
+        error_if(aggregates[i].op != AGGREGATE_COUNT && aggregates[i].field >= src->num_types,ERROR_INVALID_FIELD);
+        error_if(aggregates[i].op != AGGREGATE_COUNT && (src->types[aggregates[i].field] == VOID || src->types[aggregates[i].field] == NESTED
+            || src->types[aggregates[i].field] == STR16 || src->types[aggregates[i].field] == STR32 || src->types[aggregates[i].field] == STRING),ERROR_INVALID_TYPE);
+    }
+    #endif
+
+    struct group_job job;
+    job.src = src;
+    job.num_keys = num_keys;
+    job.key_fields = key_fields;
+    job.num_aggregates = num_aggregates;
+    job.aggregates = aggregates;
+    job.num_partitions = num_threads == 0 ? 1 : num_threads;
+    if (job.num_partitions > src->num_elements / CONSTRUCT_CONVERT_CHUNK + 1)
+        job.num_partitions = src->num_elements / CONSTRUCT_CONVERT_CHUNK + 1;
+    struct group_table* locals = malloc(sizeof(struct group_table) * job.num_partitions);
+    struct group_table* partitions = malloc(sizeof(struct group_table) * job.num_partitions);
+    job.locals = locals;
+    job.partitions = partitions;
+    for (i = 0; i < job.num_partitions; i++)
+    {
+        util_group_init(locals + i,util_key_size(src,num_keys,key_fields),num_aggregates);
+        util_group_init(partitions + i,locals[i].key_size,num_aggregates);
+    }
+
+    util_run_parallel(job.num_partitions,util_group_range,&job);
+    if (job.num_partitions > 1)
+    {
+        util_run_parallel(job.num_partitions,util_group_merge,&job);
+        for (i = 0; i < job.num_partitions; i++)
+            util_group_free(locals + i);
+    }
+    else
+        partitions[0] = locals[0];
+
+    enum construct_types* types = malloc(sizeof(enum construct_types) * (num_keys + num_aggregates));
+    for (i = 0; i < num_keys; i++)
+        types[i] = src->types[key_fields[i]];
+    for (i = 0; i < num_aggregates; i++)
+        types[num_keys + i] = aggregates[i].op == AGGREGATE_COUNT ? UINT64 : DOUBLE;
+    for (i = 0; i < job.num_partitions; i++)
+        num_groups += partitions[i].num_groups;
+    buffer result = util_create_buffer(num_groups,num_keys + num_aggregates,types);
+    for (i = 0; i < num_keys; i++)
+        util_share_field_dictionary(result,i,src,key_fields[i]);
+
+    unsigned int element = 0, group;
+    for (i = 0; i < job.num_partitions; i++)
+    {
+        struct group_table* groups = partitions + i;
+        for (group = 0; group < groups->num_groups; group++, element++)
+        {
+            util_store_key(result,element,0,num_keys,groups->keys + (unsigned long)groups->key_size * group);
+            unsigned char* data = (unsigned char*)result->data_buffer + result->stride * element;
+            const double* accumulators = groups->values + (unsigned long)num_aggregates * group;
+            for (j = 0; j < num_aggregates; j++)
+            {
+                if (aggregates[j].op == AGGREGATE_COUNT)
+                    memcpy(data + result->offsets[num_keys + j],groups->counts + group,sizeof(unsigned long long));
+                else
+                {
+                    double value = aggregates[j].op == AGGREGATE_MEAN ? accumulators[j] / groups->counts[group] : accumulators[j];
+                    memcpy(data + result->offsets[num_keys + j],&value,sizeof(double));
+                }
+            }
+        }
+        util_group_free(groups);
+    }
+    free(locals);
+    free(partitions);
+    return result;
+}
+
+buffer group_by(unsigned int num_keys, const unsigned int* key_fields, unsigned int num_aggregates, const struct construct_aggregate* aggregates, unsigned int num_threads)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return group_buffer_by(CURRENT_BUFFER,num_keys,key_fields,num_aggregates,aggregates,num_threads);
+}
+
+unsigned int get_buffer_sorted_field(buffer target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    return target->sorted_by - 1;
+}
+
+void set_buffer_sorted_field(buffer target, unsigned int field)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field != (unsigned int)-1 && field >= target->num_types,ERROR_INVALID_FIELD);
+    #endif
+    target->sorted_by = field + 1;
+}
+
+/* Inputs whose right side has more elements than this are radix partitioned by hash first, so every partial hash table stays in the caches */
+#ifndef CONSTRUCT_JOIN_PARTITION_ELEMENTS
+    #define CONSTRUCT_JOIN_PARTITION_ELEMENTS 4096
+#endif
+#define CONSTRUCT_JOIN_MAX_PARTITION_BITS 10
+
+struct key_column
+{
+    enum construct_types type;
+    unsigned int key_size,num_elements;
+    unsigned int* hashes;
+    unsigned char* keys;
+};
+
+struct join_pairs
+{
+    unsigned int num_pairs,capacity;
+    unsigned int* left;
+    unsigned int* right;
+};
+
+static void util_load_key_column(struct key_column* column, buffer src, unsigned int field, unsigned int hash)
+{
+    unsigned int i, k, num_values;
+    column->type = util_is_encoded_type(src->types[field]) ? INT64 : src->types[field];
+    column->key_size = column->type == BIT ? 1 : sizes[column->type];
+    column->num_elements = src->num_elements;
+    column->keys = malloc((unsigned long)column->key_size * src->num_elements + 1);
+    column->hashes = hash ? malloc(sizeof(unsigned int) * src->num_elements + 1) : NULL;
+
+    if (util_is_encoded_type(src->types[field]))
+    {
+        long long values[CONSTRUCT_CONVERT_CHUNK];
+        for (i = 0; i < src->num_elements; i += num_values)
+        {
+            num_values = src->num_elements - i < CONSTRUCT_CONVERT_CHUNK ? src->num_elements - i : CONSTRUCT_CONVERT_CHUNK;
+            util_load_integers(src->types[field],(const unsigned char*)src->data_buffer + src->stride * i + src->offsets[field],src->stride,num_values,values);
+            for (k = 0; k < num_values; k++)
+                values[k] = src->dictionaries[field]->values[values[k]];
+            memcpy(column->keys + sizeof(long long) * i,values,sizeof(long long) * num_values);
+        }
+    }
+    else
+        for (i = 0; i < src->num_elements; i++)
+            util_load_key(src,i,1,&field,column->keys + (unsigned long)column->key_size * i);
+
+    if (hash)
+        for (i = 0; i < src->num_elements; i++)
+            column->hashes[i] = util_hash_bytes(column->keys + (unsigned long)column->key_size * i,column->key_size);
+}
+
+#define util_compare_as(type) ((*(const type*)a > *(const type*)b) - (*(const type*)a < *(const type*)b))
+
+static int util_compare_keys(enum construct_types type, const unsigned char* a, const unsigned char* b)
+{
+    switch (type)
+    {
+        case UINT: return util_compare_as(unsigned int);
+        case INT: return util_compare_as(int);
+        case FLOAT: return util_compare_as(float);
+        case CHAR: return util_compare_as(char);
+        case UCHAR: case BIT: return util_compare_as(unsigned char);
+        case INT8: return util_compare_as(signed char);
+        case INT16: return util_compare_as(short);
+        case UINT16: return util_compare_as(unsigned short);
+        case INT64: return util_compare_as(long long);
+        case UINT64: return util_compare_as(unsigned long long);
+        case DOUBLE: return util_compare_as(double);
+        case HALF:
+        {
+            float x = half_to_float(*(const unsigned short*)a), y = half_to_float(*(const unsigned short*)b);
+            return (x > y) - (x < y);
+        }
+        case STR16: case STR32: return strcmp((const char*)a,(const char*)b);
+        case STRING: return strcmp(get_interned_string(*(const unsigned int*)a),get_interned_string(*(const unsigned int*)b));
+        default: return util_compare_as(unsigned char*);
+    }
+}
+
+/* Returns 1 if the keys are equal, floating point keys comparing numerically (So -0.0 equals 0.0 and NaN equals nothing) */
+static unsigned int util_equal_keys(const struct key_column* column, const unsigned char* a, const unsigned char* b)
+{
+    switch (column->type)
+    {
+        case FLOAT: return *(const float*)a == *(const float*)b;
+        case DOUBLE: return *(const double*)a == *(const double*)b;
+        case HALF: return half_to_float(*(const unsigned short*)a) == half_to_float(*(const unsigned short*)b);
+        default: return memcmp(a,b,column->key_size) == 0;
+    }
+}
+
+static void util_join_emit(struct join_pairs* pairs, unsigned int left, unsigned int right)
+{
+    if (pairs->num_pairs == pairs->capacity)
+    {
+        pairs->capacity = pairs->capacity == 0 ? 64 : pairs->capacity * 2;
+        pairs->left = realloc(pairs->left,sizeof(unsigned int) * pairs->capacity);
+        pairs->right = realloc(pairs->right,sizeof(unsigned int) * pairs->capacity);
+    }
+    pairs->left[pairs->num_pairs] = left;
+    pairs->right[pairs->num_pairs++] = right;
+}
+
+static void util_hash_join(const struct key_column* left, const unsigned int* left_indices, unsigned int num_left,
+    const struct key_column* right, const unsigned int* right_indices, unsigned int num_right, enum construct_join_kinds kind, struct join_pairs* pairs)
+{
+    unsigned int i, j, l, r, matched, table_size = 16;
+    while (table_size < num_right * 2)
+        table_size *= 2;
+    unsigned int* heads = malloc(sizeof(unsigned int) * table_size);
+    unsigned int* next = malloc(sizeof(unsigned int) * num_right + 1);
+    memset(heads,0,sizeof(unsigned int) * table_size);
+
+    for (j = num_right; j-- > 0;)
+    {
+        r = right_indices == NULL ? j : right_indices[j];
+        next[j] = heads[right->hashes[r] & (table_size - 1)];
+        heads[right->hashes[r] & (table_size - 1)] = j + 1;
+    }
+    for (i = 0; i < num_left; i++)
+    {
+        l = left_indices == NULL ? i : left_indices[i];
+        matched = 0;
+        for (j = heads[left->hashes[l] & (table_size - 1)]; j != 0; j = next[j - 1])
+        {
+            r = right_indices == NULL ? j - 1 : right_indices[j - 1];
+            if (right->hashes[r] == left->hashes[l] && util_equal_keys(left,left->keys + (unsigned long)left->key_size * l,right->keys + (unsigned long)right->key_size * r))
+            {
+                util_join_emit(pairs,l,r);
+                matched = 1;
+            }
+        }
+        if (!matched && kind == JOIN_LEFT)
+            util_join_emit(pairs,l,(unsigned int)-1);
+    }
+    free(heads);
+    free(next);
+}
+
+static void util_radix_partition(const struct key_column* column, unsigned int bits, unsigned int* starts, unsigned int* indices)
+{
+    unsigned int i, num_partitions = 1u << bits;
+    unsigned int cursors[1u << CONSTRUCT_JOIN_MAX_PARTITION_BITS];
+    memset(starts,0,sizeof(unsigned int) * (num_partitions + 1));
+    for (i = 0; i < column->num_elements; i++)
+        starts[(column->hashes[i] >> (32 - bits)) + 1]++;
+    for (i = 0; i < num_partitions; i++)
+        starts[i + 1] += starts[i];
+    memcpy(cursors,starts,sizeof(unsigned int) * num_partitions);
+    for (i = 0; i < column->num_elements; i++)
+        indices[cursors[column->hashes[i] >> (32 - bits)]++] = i;
+}
+
+static void util_radix_join(const struct key_column* left, const struct key_column* right, enum construct_join_kinds kind, struct join_pairs* pairs)
+{
+    unsigned int i, p, bits = 1;
+    while (bits < CONSTRUCT_JOIN_MAX_PARTITION_BITS && (right->num_elements >> bits) > CONSTRUCT_JOIN_PARTITION_ELEMENTS)
+        bits++;
+    unsigned int left_starts[(1u << CONSTRUCT_JOIN_MAX_PARTITION_BITS) + 1], right_starts[(1u << CONSTRUCT_JOIN_MAX_PARTITION_BITS) + 1];
+    unsigned int* left_indices = malloc(sizeof(unsigned int) * left->num_elements + 1);
+    unsigned int* right_indices = malloc(sizeof(unsigned int) * right->num_elements + 1);
+    struct join_pairs partitioned = {0,0,NULL,NULL};
+
+    util_radix_partition(left,bits,left_starts,left_indices);
+    util_radix_partition(right,bits,right_starts,right_indices);
+    for (p = 0; p < 1u << bits; p++)
+        util_hash_join(left,left_indices + left_starts[p],left_starts[p + 1] - left_starts[p],
+            right,right_indices + right_starts[p],right_starts[p + 1] - right_starts[p],kind,&partitioned);
+    free(right_indices);
+
+    unsigned int* starts = left_indices;
+    memset(starts,0,sizeof(unsigned int) * left->num_elements + 1);
+    for (i = 0; i < partitioned.num_pairs; i++)
+        if (partitioned.left[i] + 1 < left->num_elements)
+            starts[partitioned.left[i] + 1]++;
+    for (i = 1; i < left->num_elements; i++)
+        starts[i] += starts[i - 1];
+    pairs->num_pairs = pairs->capacity = partitioned.num_pairs;
+    pairs->left = malloc(sizeof(unsigned int) * partitioned.num_pairs + 1);
+    pairs->right = malloc(sizeof(unsigned int) * partitioned.num_pairs + 1);
+    for (i = 0; i < partitioned.num_pairs; i++)
+    {
+        p = starts[partitioned.left[i]]++;
+        pairs->left[p] = partitioned.left[i];
+        pairs->right[p] = partitioned.right[i];
+    }
+    free(starts);
+    free(partitioned.left);
+    free(partitioned.right);
+}
+
+static void util_merge_join(const struct key_column* left, const struct key_column* right, enum construct_join_kinds kind, struct join_pairs* pairs)
+{
+    unsigned int i, j = 0, end, matched;
+    for (i = 0; i < left->num_elements; i++)
+    {
+        const unsigned char* key = left->keys + (unsigned long)left->key_size * i;
+        /* NaNs match nothing, so the right ones are skipped wherever the sort left them and the left ones stay unmatched */
+        while (j < right->num_elements && (util_compare_keys(left->type,right->keys + (unsigned long)right->key_size * j,key) < 0 ||
+            !util_equal_keys(right,right->keys + (unsigned long)right->key_size * j,right->keys + (unsigned long)right->key_size * j)))
+            j++;
+        for (end = j, matched = 0; end < right->num_elements && util_equal_keys(left,key,key) && util_compare_keys(left->type,right->keys + (unsigned long)right->key_size * end,key) == 0; end++)
+            if (util_equal_keys(right,right->keys + (unsigned long)right->key_size * end,right->keys + (unsigned long)right->key_size * end))
+            {
+                util_join_emit(pairs,i,end);
+                matched = 1;
+            }
+        if (!matched && kind == JOIN_LEFT)
+            util_join_emit(pairs,i,(unsigned int)-1);
+    }
+}
+
+static void util_join_copy(buffer dest, unsigned int element, unsigned int first_field, buffer src, unsigned int src_element)
+{
+    unsigned char* to = (unsigned char*)dest->data_buffer + dest->stride * element;
+    const unsigned char* from = (const unsigned char*)src->data_buffer + src->stride * src_element;
+    unsigned int j;
+    for (j = 0; j < src->num_types; j++)
+    {
+        if (src->types[j] == BIT)
+            set_bit_field(to + dest->offsets[first_field + j],dest->offsets[dest->num_types + 1 + first_field + j],(from[src->offsets[j]] & src->offsets[src->num_types + 1 + j]) != 0);
+        else
+            memcpy(to + dest->offsets[first_field + j],from + src->offsets[j],sizes[src->types[j]]);
+    }
+}
+
+buffer join_buffer(buffer left, unsigned int left_field, buffer right, unsigned int right_field, enum construct_join_kinds kind)
+{
+    #ifdef ERROR_CHECKING
+    error_if(left == NULL || right == NULL,ERROR_BAD_BUFFER);
+    error_if(left_field >= left->num_types || right_field >= right->num_types,ERROR_INVALID_FIELD);
+    error_if(kind > JOIN_LEFT,ERROR_INVALID_DATA);
+    error_if(left->types[left_field] != right->types[right_field] && !(util_is_encoded_type(left->types[left_field]) && util_is_encoded_type(right->types[right_field])),ERROR_BAD_TYPES);
+    #endif
+    unsigned int i, merge = left->sorted_by == left_field + 1 && right->sorted_by == right_field + 1;
+    struct key_column left_side, right_side;
+    struct join_pairs pairs = {0,0,NULL,NULL};
+
+    util_load_key_column(&left_side,left,left_field,!merge);
+    util_load_key_column(&right_side,right,right_field,!merge);
+    /* Merge joins when both sides are known to be sorted by their keys, hash joins otherwise, radix partitioning both sides by hash first when right is large */
+    if (merge)
+        util_merge_join(&left_side,&right_side,kind,&pairs);
+    else if (right->num_elements <= CONSTRUCT_JOIN_PARTITION_ELEMENTS)
+        util_hash_join(&left_side,NULL,left->num_elements,&right_side,NULL,right->num_elements,kind,&pairs);
+    else
+        util_radix_join(&left_side,&right_side,kind,&pairs);
+    free(left_side.keys);
+    free(left_side.hashes);
+    free(right_side.keys);
+    free(right_side.hashes);
+
+    unsigned int num_types = left->num_types + right->num_types + (kind == JOIN_LEFT);
+    enum construct_types* types = malloc(sizeof(enum construct_types) * num_types);
+    memcpy(types,left->types,sizeof(enum construct_types) * left->num_types);
+    memcpy(types + left->num_types,right->types,sizeof(enum construct_types) * right->num_types);
+    if (kind == JOIN_LEFT)
+        types[num_types - 1] = BIT;
+    buffer result = util_create_buffer(pairs.num_pairs,num_types,types);
+    for (i = 0; i < left->num_types; i++)
+        util_share_field_dictionary(result,i,left,i);
+    for (i = 0; i < right->num_types; i++)
+        util_share_field_dictionary(result,left->num_types + i,right,i);
+
+    for (i = 0; i < pairs.num_pairs; i++)
+    {
+        if (pairs.right[i] == (unsigned int)-1)
+            util_zero_elements(result,i,1);
+        util_join_copy(result,i,0,left,pairs.left[i]);
+        if (pairs.right[i] != (unsigned int)-1)
+            util_join_copy(result,i,left->num_types,right,pairs.right[i]);
+        if (kind == JOIN_LEFT)
+            set_bit_field((unsigned char*)result->data_buffer + result->stride * i + result->offsets[num_types - 1],result->offsets[num_types + num_types],pairs.right[i] != (unsigned int)-1);
+    }
+    if (left->sorted_by == left_field + 1)
+        result->sorted_by = left_field + 1;
+    free(pairs.left);
+    free(pairs.right);
+    return result;
+}
+
+buffer join(unsigned int left_field, buffer right, unsigned int right_field, enum construct_join_kinds kind)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return join_buffer(CURRENT_BUFFER,left_field,right,right_field,kind);
+}
+
+struct select_order
+{
+    struct key_column column;
+    unsigned int descending;
+};
+
+static int util_select_before(const struct select_order* order, unsigned int a, unsigned int b)
+{
+    int comparison = util_compare_keys(order->column.type,order->column.keys + (unsigned long)order->column.key_size * a,order->column.keys + (unsigned long)order->column.key_size * b);
+    if (order->descending)
+        comparison = -comparison;
+    return comparison < 0 || (comparison == 0 && a < b);
+}
+
+static void util_sift_down(const struct select_order* order, unsigned int* heap, unsigned int size, unsigned int i)
+{
+    unsigned int child, top = heap[i];
+    while ((child = 2 * i + 1) < size)
+    {
+        if (child + 1 < size && util_select_before(order,heap[child],heap[child + 1]))
+            child++;
+        if (!util_select_before(order,top,heap[child]))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = top;
+}
+
+static void util_heap_sort(const struct select_order* order, unsigned int* indices, unsigned int num_indices)
+{
+    unsigned int i, top;
+    for (i = num_indices / 2; i-- > 0;)
+        util_sift_down(order,indices,num_indices,i);
+    for (i = num_indices; i-- > 1;)
+    {
+        top = indices[0];
+        indices[0] = indices[i];
+        indices[i] = top;
+        util_sift_down(order,indices,i,0);
+    }
+}
+
+static void util_heap_select(const struct select_order* order, unsigned int num_elements, unsigned int k, unsigned int* heap)
+{
+    unsigned int i;
+    if (k == 0)
+        return;
+    for (i = 0; i < k; i++)
+        heap[i] = i;
+    for (i = k / 2; i-- > 0;)
+        util_sift_down(order,heap,k,i);
+    for (i = k; i < num_elements; i++)
+        if (util_select_before(order,i,heap[0]))
+        {
+            heap[0] = i;
+            util_sift_down(order,heap,k,0);
+        }
+    for (i = k; i-- > 1;)
+    {
+        unsigned int top = heap[0];
+        heap[0] = heap[i];
+        heap[i] = top;
+        util_sift_down(order,heap,i,0);
+    }
+}
+
+#define util_swap_indices(a,b) do { unsigned int temp = indices[a]; indices[a] = indices[b]; indices[b] = temp; } while (0)
+
+static void util_introselect(const struct select_order* order, unsigned int* indices, unsigned int num_indices, unsigned int nth)
+{
+    unsigned int low = 0, high = num_indices, depth = 0, i, j, store;
+    for (i = num_indices; i > 1; i /= 2)
+        depth += 2;
+
+    while (high - low > 16)
+    {
+        if (depth-- == 0)
+        {
+            util_heap_sort(order,indices + low,high - low);
+            return;
+        }
+        unsigned int middle = low + (high - low) / 2;
+        if (util_select_before(order,indices[middle],indices[low]))
+            util_swap_indices(middle,low);
+        if (util_select_before(order,indices[high - 1],indices[middle]))
+        {
+            util_swap_indices(high - 1,middle);
+            if (util_select_before(order,indices[middle],indices[low]))
+                util_swap_indices(middle,low);
+        }
+        util_swap_indices(middle,high - 1);
+        for (store = j = low; j < high - 1; j++)
+            if (util_select_before(order,indices[j],indices[high - 1]))
+            {
+                util_swap_indices(store,j);
+                store++;
+            }
+        util_swap_indices(store,high - 1);
+        if (store == nth)
+            return;
+        if (nth < store)
+            high = store;
+        else
+            low = store + 1;
+    }
+    for (i = low + 1; i < high; i++)
+    {
+        unsigned int index = indices[i];
+        for (j = i; j > low && util_select_before(order,index,indices[j - 1]); j--)
+            indices[j] = indices[j - 1];
+        indices[j] = index;
+    }
+}
+
+static void util_select_prepare(struct select_order* order, buffer src, unsigned int field, unsigned int descending)
+{
+    util_load_key_column(&order->column,src,field,0);
+    order->descending = descending;
+}
+
+static void util_apply_order(buffer target, const unsigned int* indices)
+{
+    unsigned int i, size = util_get_size(target);
+    unsigned char* gathered = malloc((unsigned long)size * target->num_elements + 1);
+    util_prepare_write(target);
+    for (i = 0; i < target->num_elements; i++)
+        memcpy(gathered + (unsigned long)size * i,(unsigned char*)target->data_buffer + target->stride * indices[i],size);
+    for (i = 0; i < target->num_elements; i++)
+        memcpy((unsigned char*)target->data_buffer + target->stride * i,gathered + (unsigned long)size * i,size);
+    count_stat(target,bytes_copied,2ul * size * target->num_elements);
+    free(gathered);
+}
+
+buffer top_buffer_k_indices(buffer src, unsigned int field, unsigned int k, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= src->num_types,ERROR_INVALID_FIELD);
+    #endif
+    struct select_order order;
+    enum construct_types* types = malloc(sizeof(enum construct_types));
+    types[0] = UINT;
+    if (k > src->num_elements)
+        k = src->num_elements;
+    buffer result = util_create_buffer(k,1,types);
+    util_select_prepare(&order,src,field,descending);
+    util_heap_select(&order,src->num_elements,k,result->data_buffer);
+    free(order.column.keys);
+    return result;
+}
+
+buffer top_buffer_k(buffer src, unsigned int field, unsigned int k, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= src->num_types,ERROR_INVALID_FIELD);
+    #endif
+    struct select_order order;
+    unsigned int i;
+    if (k > src->num_elements)
+        k = src->num_elements;
+    unsigned int* indices = malloc(sizeof(unsigned int) * k + 1);
+    util_select_prepare(&order,src,field,descending);
+    util_heap_select(&order,src->num_elements,k,indices);
+    free(order.column.keys);
+
+    buffer result = util_create_buffer_like(k,src);
+    for (i = 0; i < k; i++)
+        util_copy_elements(result,i,src,indices[i],1);
+    if (!descending)
+        result->sorted_by = field + 1;
+    free(indices);
+    return result;
+}
+
+void partial_sort_buffer(buffer target, unsigned int field, unsigned int k, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    #endif
+    struct select_order order;
+    unsigned int i;
+    count_stat(target,sorts,1);
+    if (k > target->num_elements)
+        k = target->num_elements;
+    if (k == 0)
+        return;
+    unsigned int* indices = malloc(sizeof(unsigned int) * target->num_elements);
+    for (i = 0; i < target->num_elements; i++)
+        indices[i] = i;
+    util_select_prepare(&order,target,field,descending);
+    if (k < target->num_elements)
+        util_introselect(&order,indices,target->num_elements,k - 1);
+    util_heap_sort(&order,indices,k);
+    free(order.column.keys);
+    util_apply_order(target,indices);
+    if (k == target->num_elements && !descending)
+        target->sorted_by = field + 1;
+    free(indices);
+}
+
+void nth_element_buffer(buffer target, unsigned int field, unsigned int nth, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(field >= target->num_types,ERROR_INVALID_FIELD);
+    error_if(nth >= target->num_elements,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+    struct select_order order;
+    unsigned int i;
+    count_stat(target,sorts,1);
+    unsigned int* indices = malloc(sizeof(unsigned int) * target->num_elements);
+    for (i = 0; i < target->num_elements; i++)
+        indices[i] = i;
+    util_select_prepare(&order,target,field,descending);
+    util_introselect(&order,indices,target->num_elements,nth);
+    free(order.column.keys);
+    util_apply_order(target,indices);
+    free(indices);
+}
+
+buffer top_k_indices(unsigned int field, unsigned int k, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return top_buffer_k_indices(CURRENT_BUFFER,field,k,descending);
+}
+
+buffer top_k(unsigned int field, unsigned int k, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return top_buffer_k(CURRENT_BUFFER,field,k,descending);
+}
+
+void partial_sort(unsigned int field, unsigned int k, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    partial_sort_buffer(CURRENT_BUFFER,field,k,descending);
+}
+
+void nth_element(unsigned int field, unsigned int nth, unsigned int descending)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    nth_element_buffer(CURRENT_BUFFER,field,nth,descending);
+}
+
+static unsigned int util_distinct_indices(buffer src, unsigned int num_keys, const unsigned int* key_fields, unsigned int* indices)
+{
+    unsigned int i, added, num_distinct = 0, key_size = util_key_size(src,num_keys,key_fields);
+    unsigned char* key = malloc(key_size * 2 + 1);
+    unsigned char* previous = key + key_size;
+    struct group_table seen;
+
+    if (num_keys == 1 && src->sorted_by == key_fields[0] + 1)
+    {
+        for (i = 0; i < src->num_elements; i++)
+        {
+            util_load_key(src,i,1,key_fields,key);
+            if (i == 0 || memcmp(key,previous,key_size) != 0)
+            {
+                indices[num_distinct++] = i;
+                memcpy(previous,key,key_size);
+            }
+        }
+        free(key);
+        return num_distinct;
+    }
+
+    util_group_init(&seen,key_size,0);
+    for (i = 0; i < src->num_elements; i++)
+    {
+        util_load_key(src,i,num_keys,key_fields,key);
+        util_group_find(&seen,key,util_hash_bytes(key,key_size),&added);
+        if (added)
+            indices[num_distinct++] = i;
+    }
+    util_group_free(&seen);
+    free(key);
+    return num_distinct;
+}
+
+buffer distinct_buffer(buffer src, unsigned int num_keys, const unsigned int* key_fields)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(num_keys == 0 || key_fields == NULL,ERROR_INVALID_DATA);
+    #endif
+    unsigned int i, run;
+    #ifdef ERROR_CHECKING
+    for (i = 0; i < num_keys; i++)
+        error_if(key_fields[i] >= src->num_types,ERROR_INVALID_FIELD);
+    #endif
+    unsigned int* indices = malloc(sizeof(unsigned int) * src->num_elements + 1);
+    unsigned int num_distinct = util_distinct_indices(src,num_keys,key_fields,indices);
+
+    buffer result = util_create_buffer_like(num_distinct,src);
+    for (i = 0; i < num_distinct; i += run)
+    {
+        for (run = 1; i + run < num_distinct && indices[i + run] == indices[i] + run; run++)
+            ;
+        util_copy_elements(result,i,src,indices[i],run);
+    }
+    result->sorted_by = src->sorted_by;
+    free(indices);
+    return result;
+}
+
+unsigned int dedup_buffer_in_place(buffer target, unsigned int num_keys, const unsigned int* key_fields)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(num_keys == 0 || key_fields == NULL,ERROR_INVALID_DATA);
+    error_if(target->parent != NULL,ERROR_RESIZED_VIEW);
+    error_if(target->arena != NULL,ERROR_ARENA_BUFFER);
+    #endif
+    unsigned int i, sorted_by = target->sorted_by;
+    #ifdef ERROR_CHECKING
+    for (i = 0; i < num_keys; i++)
+        error_if(key_fields[i] >= target->num_types,ERROR_INVALID_FIELD);
+    #endif
+    unsigned int* indices = malloc(sizeof(unsigned int) * target->num_elements + 1);
+    unsigned int num_distinct = util_distinct_indices(target,num_keys,key_fields,indices);
+
+    if (num_distinct != target->num_elements)
+    {
+        util_prepare_write(target);
+        for (i = 0; i < num_distinct; i++)
+            if (indices[i] != i)
+                util_copy_elements(target,i,target,indices[i],1);
+        resize_buffer(target,num_distinct);
+        target->sorted_by = sorted_by;
+    }
+    free(indices);
+    return num_distinct;
+}
+
+buffer distinct(unsigned int num_keys, const unsigned int* key_fields)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return distinct_buffer(CURRENT_BUFFER,num_keys,key_fields);
+}
+
+unsigned int dedup_in_place(unsigned int num_keys, const unsigned int* key_fields)
+{
+    #ifdef ERROR_CHECKING
+    error_if(CURRENT_BUFFER == NULL,ERROR_NO_BOUND_BUFFER);
+    #endif
+    return dedup_buffer_in_place(CURRENT_BUFFER,num_keys,key_fields);
+}
+
+/* Bytes the producer and consumer indices of a ring are kept apart by, so the threads updating them don't share a cache line */
+#define CONSTRUCT_CACHE_LINE 64
+
+/* Spins a thread waiting on another one does before giving up the rest of its time slice, in case the other one isn't running */
+#define CONSTRUCT_SPINS 64
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define util_cpu_relax() __builtin_ia32_pause()
+#else
+    #define util_cpu_relax()
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sched.h>
+    #define util_yield() sched_yield()
+#else
+    #define util_yield()
+#endif
+
+struct ring_index
+{
+    unsigned int reserve,commit;
+    unsigned char padding[CONSTRUCT_CACHE_LINE - 2 * sizeof(unsigned int)];
+};
+
+struct ring
+{
+    unsigned char* slots;
+    unsigned int* sequences;
+    buffer schema;
+    unsigned int element_size,capacity;
+    unsigned char padding[CONSTRUCT_CACHE_LINE];
+    struct ring_index producer;
+    struct ring_index consumer;
+};
+
+ring init_ring(unsigned int capacity, buffer schema, enum construct_ring_kinds kind)
+{
+    #ifdef ERROR_CHECKING
+    error_if(schema == NULL,ERROR_BAD_BUFFER);
+    error_if(capacity == 0 || capacity > 1u << 31,ERROR_INVALID_DATA);
+    error_if(kind > RING_MPMC,ERROR_INVALID_DATA);
+    error_if(schema->dictionaries != NULL,ERROR_INVALID_TYPE);
+    #endif
+    unsigned int i;
+    ring target = malloc(sizeof(struct ring));
+    memset(target,0,sizeof(struct ring));
+    for (target->capacity = 1; target->capacity < capacity; target->capacity *= 2)
+        ;
+    target->schema = util_create_buffer_like(0,schema);
+    target->element_size = util_get_size(schema);
+    target->slots = malloc((unsigned long)target->element_size * target->capacity);
+    target->sequences = NULL;
+    if (kind == RING_MPMC)
+    {
+        target->sequences = malloc(sizeof(unsigned int) * target->capacity);
+        for (i = 0; i < target->capacity; i++)
+            target->sequences[i] = i;
+    }
+    return target;
+}
+
+void deinit_ring(ring target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    deinit_buffer(target->schema);
+    free(target->slots);
+    free(target->sequences);
+    free(target);
+}
+
+unsigned int get_ring_capacity(ring target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    return target->capacity;
+}
+
+unsigned int get_ring_length(ring target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    unsigned int consumed, produced;
+    if (target->sequences != NULL)
+    {
+        consumed = __atomic_load_n(&target->consumer.reserve,__ATOMIC_ACQUIRE);
+        produced = __atomic_load_n(&target->producer.reserve,__ATOMIC_ACQUIRE);
+    }
+    else
+    {
+        consumed = __atomic_load_n(&target->consumer.commit,__ATOMIC_ACQUIRE);
+        produced = __atomic_load_n(&target->producer.commit,__ATOMIC_ACQUIRE);
+    }
+    return produced - consumed < target->capacity ? produced - consumed : target->capacity;
+}
+
+static unsigned int util_ring_reserve(const struct ring_index* own, const struct ring_index* other, unsigned int space, unsigned int num_elements)
+{
+    unsigned int count = __atomic_load_n(&other->commit,__ATOMIC_ACQUIRE) + space - own->reserve;
+    return count < num_elements ? count : num_elements;
+}
+
+static unsigned int util_ring_claim(ring target, struct ring_index* own, unsigned int ready, unsigned int* position)
+{
+    unsigned int sequence;
+    *position = __atomic_load_n(&own->reserve,__ATOMIC_RELAXED);
+    for (;;)
+    {
+        sequence = __atomic_load_n(&target->sequences[*position & (target->capacity - 1)],__ATOMIC_ACQUIRE);
+        if (sequence == *position + ready)
+        {
+            if (__atomic_compare_exchange_n(&own->reserve,position,*position + 1,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED))
+                return 1;
+        }
+        else if ((int)(sequence - (*position + ready)) < 0)
+            return 0;
+        else
+            *position = __atomic_load_n(&own->reserve,__ATOMIC_RELAXED);
+    }
+}
+
+#ifdef ERROR_CHECKING
+static unsigned int util_same_schema(buffer schema, buffer data)
+{
+    return schema->num_types == data->num_types && memcmp(schema->types,data->types,sizeof(enum construct_types) * data->num_types) == 0;
+}
+#endif
+
+static void util_ring_check(ring target, buffer data, unsigned int index, unsigned int num_elements)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL || data == NULL,ERROR_BAD_BUFFER);
+    error_if(index > data->num_elements || num_elements > data->num_elements - index,ERROR_OUT_OF_BOUNDS_INDEX);
+    error_if(!util_same_schema(target->schema,data),ERROR_BAD_TYPES);
+    #else
+    (void)target;
+    (void)data;
+    (void)index;
+    (void)num_elements;
+    #endif
+}
+
+unsigned int push_ring(ring target, buffer src, unsigned int index, unsigned int num_elements)
+{
+    util_ring_check(target,src,index,num_elements);
+    unsigned int i, position, count;
+    if (target->sequences != NULL)
+    {
+        for (count = 0; count < num_elements && util_ring_claim(target,&target->producer,0,&position); count++)
+        {
+            memcpy(target->slots + (unsigned long)target->element_size * (position & (target->capacity - 1)),(unsigned char*)src->data_buffer + src->stride * (index + count),target->element_size);
+            __atomic_store_n(&target->sequences[position & (target->capacity - 1)],position + 1,__ATOMIC_RELEASE);
+        }
+        return count;
+    }
+    count = util_ring_reserve(&target->producer,&target->consumer,target->capacity,num_elements);
+    for (i = 0; i < count; i++)
+    {
+        position = (target->producer.reserve + i) & (target->capacity - 1);
+        memcpy(target->slots + (unsigned long)target->element_size * position,(unsigned char*)src->data_buffer + src->stride * (index + i),target->element_size);
+    }
+    target->producer.reserve += count;
+    __atomic_store_n(&target->producer.commit,target->producer.reserve,__ATOMIC_RELEASE);
+    return count;
+}
+
+unsigned int pop_ring(ring target, buffer dest, unsigned int index, unsigned int num_elements)
+{
+    util_ring_check(target,dest,index,num_elements);
+    util_prepare_write(dest);
+    unsigned int i, position, count;
+    if (target->sequences != NULL)
+    {
+        for (count = 0; count < num_elements && util_ring_claim(target,&target->consumer,1,&position); count++)
+        {
+            memcpy((unsigned char*)dest->data_buffer + dest->stride * (index + count),target->slots + (unsigned long)target->element_size * (position & (target->capacity - 1)),target->element_size);
+            __atomic_store_n(&target->sequences[position & (target->capacity - 1)],position + target->capacity,__ATOMIC_RELEASE);
+        }
+        return count;
+    }
+    count = util_ring_reserve(&target->consumer,&target->producer,0,num_elements);
+    for (i = 0; i < count; i++)
+    {
+        position = (target->consumer.reserve + i) & (target->capacity - 1);
+        memcpy((unsigned char*)dest->data_buffer + dest->stride * (index + i),target->slots + (unsigned long)target->element_size * position,target->element_size);
+    }
+    target->consumer.reserve += count;
+    __atomic_store_n(&target->consumer.commit,target->consumer.reserve,__ATOMIC_RELEASE);
+    return count;
+}
+
+struct appender
+{
+    buffer elements;
+    unsigned int capacity,encoding;
+    unsigned char padding[CONSTRUCT_CACHE_LINE];
+    unsigned long reserved;
+    unsigned char gap[CONSTRUCT_CACHE_LINE - sizeof(unsigned long)];
+    unsigned long committed;
+};
+
+appender init_appender(unsigned int capacity, buffer schema)
+{
+    #ifdef ERROR_CHECKING
+    error_if(schema == NULL,ERROR_BAD_BUFFER);
+    error_if(capacity > 1u << 31,ERROR_INVALID_DATA);
+    #endif
+    appender target = malloc(sizeof(struct appender));
+    memset(target,0,sizeof(struct appender));
+    target->elements = util_create_buffer_like(capacity,schema);
+    util_unshare_dictionaries(target->elements);
+    target->capacity = capacity;
+    return target;
+}
+
+void deinit_appender(appender target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    deinit_buffer(target->elements);
+    free(target);
+}
+
+unsigned int get_appender_length(appender target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    unsigned long committed = __atomic_load_n(&target->committed,__ATOMIC_ACQUIRE);
+    return committed < target->capacity ? committed : target->capacity;
+}
+
+/* Encodes the values of the encoded fields of the copied elements into the appender's own dictionaries, one thread at a time */
+static void util_append_codes(appender target, buffer src, unsigned int index, unsigned long start, unsigned int count)
+{
+    buffer dest = target->elements;
+    long long values[CONSTRUCT_CONVERT_CHUNK];
+    unsigned int i, j, k, num_values, spins = 0;
+    while (__atomic_exchange_n(&target->encoding,1,__ATOMIC_ACQUIRE) != 0)
+    {
+        if (++spins % CONSTRUCT_SPINS == 0)
+            util_yield();
+        else
+            util_cpu_relax();
+    }
+    for (j = 0; j < dest->num_types; j++)
+    {
+        if (dest->dictionaries[j] == NULL)
+            continue;
+        for (i = 0; i < count; i += num_values)
+        {
+            num_values = count - i < CONSTRUCT_CONVERT_CHUNK ? count - i : CONSTRUCT_CONVERT_CHUNK;
+            util_load_integers(src->types[j],(const unsigned char*)src->data_buffer + src->stride * (index + i) + src->offsets[j],src->stride,num_values,values);
+            for (k = 0; k < num_values; k++)
+                values[k] = src->dictionaries[j]->values[values[k]];
+            util_encode_values(dest->dictionaries[j],num_values,values);
+            util_store_integers(dest->types[j],(unsigned char*)dest->data_buffer + dest->stride * (start + i) + dest->offsets[j],dest->stride,num_values,values);
+        }
+    }
+    __atomic_store_n(&target->encoding,0,__ATOMIC_RELEASE);
+}
+
+unsigned int append_concurrent(appender target, buffer src, unsigned int index, unsigned int num_elements)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL || src == NULL,ERROR_BAD_BUFFER);
+    error_if(index > src->num_elements || num_elements > src->num_elements - index,ERROR_OUT_OF_BOUNDS_INDEX);
+    error_if(!util_same_schema(target->elements,src),ERROR_BAD_TYPES);
+    #endif
+    buffer dest = target->elements;
+    unsigned long start;
+    unsigned int i, count, size = util_get_size(src);
+    if (num_elements == 0 || __atomic_load_n(&target->reserved,__ATOMIC_RELAXED) >= target->capacity)
+        return 0;
+    start = __atomic_fetch_add(&target->reserved,num_elements,__ATOMIC_RELAXED);
+    if (start >= target->capacity)
+        return 0;
+    count = target->capacity - start < num_elements ? target->capacity - start : num_elements;
+    if (src->stride == size)
+        memcpy((unsigned char*)dest->data_buffer + dest->stride * start,(unsigned char*)src->data_buffer + size * index,(unsigned long)size * count);
+    else
+        for (i = 0; i < count; i++)
+            memcpy((unsigned char*)dest->data_buffer + dest->stride * (start + i),(unsigned char*)src->data_buffer + src->stride * (index + i),size);
+    if (dest->dictionaries != NULL)
+        util_append_codes(target,src,index,start,count);
+    __atomic_fetch_add(&target->committed,count,__ATOMIC_RELEASE);
+    return count;
+}
+
+buffer seal_appender(appender target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    buffer elements = target->elements;
+    unsigned long reserved = __atomic_load_n(&target->reserved,__ATOMIC_RELAXED);
+    unsigned int spins = 0, num_elements = reserved < target->capacity ? reserved : target->capacity;
+    while (__atomic_load_n(&target->committed,__ATOMIC_ACQUIRE) != num_elements)
+    {
+        if (++spins % CONSTRUCT_SPINS == 0)
+            util_yield();
+        else
+            util_cpu_relax();
+    }
+    if (num_elements < target->capacity)
+    {
+        account_bytes(((long)num_elements - (long)target->capacity) * (long)elements->stride);
+        elements->data_buffer = realloc(elements->data_buffer,(unsigned long)num_elements * elements->stride);
+    }
+    elements->num_elements = num_elements;
+    track_footprint(elements);
+    free(target);
+    return elements;
+}
+
+/* Readers that can pin versions at once, more of them wait for one to unpin */
+#define CONSTRUCT_MAX_READERS 64
+
+struct version_chunk
+{
+    buffer elements;
+    unsigned int references;
+};
+
+struct version
+{
+    struct version_chunk** chunks;
+    unsigned int num_chunks,num_elements;
+    unsigned long retired;
+    struct version* next;
+};
+
+struct versioned
+{
+    struct version* current;
+    struct version* pending;
+    struct version* retired;
+};
+
+struct reader_slot
+{
+    unsigned long epoch;
+    unsigned char padding[CONSTRUCT_CACHE_LINE - sizeof(unsigned long)];
+};
+
+static struct reader_slot READER_SLOTS[CONSTRUCT_MAX_READERS];
+static unsigned long EPOCH = 1;
+static __thread unsigned int READER_SLOT = 0;
+
+static struct version* util_create_version(unsigned int num_chunks)
+{
+    struct version* target = malloc(sizeof(struct version));
+    target->chunks = malloc(sizeof(struct version_chunk*) * num_chunks);
+    target->num_chunks = num_chunks;
+    target->num_elements = 0;
+    target->retired = 0;
+    target->next = NULL;
+    return target;
+}
+
+static void util_release_version(struct version* target)
+{
+    unsigned int i;
+    for (i = 0; i < target->num_chunks; i++)
+        if (--target->chunks[i]->references == 0)
+        {
+            deinit_buffer(target->chunks[i]->elements);
+            free(target->chunks[i]);
+        }
+    free(target->chunks);
+    free(target);
+}
+
+static void util_reclaim_versions(versioned target)
+{
+    unsigned long epoch, oldest = (unsigned long)-1;
+    struct version** link = &target->retired;
+    unsigned int i;
+    for (i = 0; i < CONSTRUCT_MAX_READERS; i++)
+    {
+        epoch = __atomic_load_n(&READER_SLOTS[i].epoch,__ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+    while (*link != NULL)
+    {
+        struct version* old = *link;
+        if (old->retired < oldest)
+        {
+            *link = old->next;
+            util_release_version(old);
+        }
+        else
+            link = &old->next;
+    }
+}
+
+versioned init_versioned(buffer src, unsigned int chunk_elements)
+{
+    #ifdef ERROR_CHECKING
+    error_if(src == NULL,ERROR_BAD_BUFFER);
+    error_if(chunk_elements == 0,ERROR_INVALID_DATA);
+    #endif
+    unsigned int i, start, count, num_chunks = src->num_elements == 0 ? 1 : (src->num_elements - 1) / chunk_elements + 1;
+    versioned target = malloc(sizeof(struct versioned));
+    target->current = util_create_version(num_chunks);
+    target->current->num_elements = src->num_elements;
+    target->pending = NULL;
+    target->retired = NULL;
+    for (i = 0; i < num_chunks; i++)
+    {
+        start = i * chunk_elements;
+        count = src->num_elements - start < chunk_elements ? src->num_elements - start : chunk_elements;
+        target->current->chunks[i] = malloc(sizeof(struct version_chunk));
+        target->current->chunks[i]->elements = util_create_buffer_like(count,src);
+        target->current->chunks[i]->references = 1;
+        if (i == 0)
+            util_unshare_dictionaries(target->current->chunks[i]->elements);
+        else
+            util_share_dictionaries(target->current->chunks[i]->elements,target->current->chunks[0]->elements);
+        util_copy_elements(target->current->chunks[i]->elements,0,src,start,count);
+    }
+    return target;
+}
+
+void deinit_versioned(versioned target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    struct version* old;
+    if (target->pending != NULL)
+        util_release_version(target->pending);
+    util_release_version(target->current);
+    while (target->retired != NULL)
+    {
+        old = target->retired;
+        target->retired = old->next;
+        util_release_version(old);
+    }
+    free(target);
+}
+
+unsigned int get_versioned_num_chunks(versioned target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    return target->current->num_chunks;
+}
+
+buffer write_versioned_chunk(versioned target, unsigned int chunk)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    error_if(chunk >= target->current->num_chunks,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+    struct version* current = target->current;
+    struct version* pending = target->pending;
+    unsigned int i;
+    if (pending == NULL)
+    {
+        pending = target->pending = util_create_version(current->num_chunks);
+        for (i = 0; i < current->num_chunks; i++)
+        {
+            pending->chunks[i] = current->chunks[i];
+            pending->chunks[i]->references++;
+        }
+    }
+    if (pending->chunks[chunk] == current->chunks[chunk])
+    {
+        current->chunks[chunk]->references--;
+        pending->chunks[chunk] = malloc(sizeof(struct version_chunk));
+        pending->chunks[chunk]->elements = copy_buffer(current->chunks[chunk]->elements);
+        util_unshare_dictionaries(pending->chunks[chunk]->elements);
+        pending->chunks[chunk]->references = 1;
+    }
+    return pending->chunks[chunk]->elements;
+}
+
+void publish_versioned(versioned target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL,ERROR_BAD_BUFFER);
+    #endif
+    struct version* pending = target->pending;
+    struct version* old;
+    unsigned int i;
+    if (pending == NULL)
+        return;
+    for (i = 0; i < pending->num_chunks; i++)
+        pending->num_elements += pending->chunks[i]->elements->num_elements;
+    target->pending = NULL;
+    old = __atomic_exchange_n(&target->current,pending,__ATOMIC_SEQ_CST);
+    old->retired = __atomic_fetch_add(&EPOCH,1,__ATOMIC_SEQ_CST);
+    old->next = target->retired;
+    target->retired = old;
+    util_reclaim_versions(target);
+}
+
+void pin_snapshot(snapshot* target, versioned src)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL || src == NULL,ERROR_BAD_BUFFER);
+    #endif
+    unsigned long unpinned, epoch;
+    unsigned int spins = 0, slot = READER_SLOT;
+    for (;;)
+    {
+        unpinned = 0;
+        epoch = __atomic_load_n(&EPOCH,__ATOMIC_SEQ_CST);
+        if (__atomic_compare_exchange_n(&READER_SLOTS[slot].epoch,&unpinned,epoch,0,__ATOMIC_SEQ_CST,__ATOMIC_RELAXED))
+            break;
+        slot = (slot + 1) % CONSTRUCT_MAX_READERS;
+        if (++spins % CONSTRUCT_MAX_READERS == 0)
+            util_yield();
+    }
+    READER_SLOT = slot;
+    target->version = __atomic_load_n(&src->current,__ATOMIC_SEQ_CST);
+    target->slot = slot;
+}
+
+void unpin_snapshot(snapshot* target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL || target->version == NULL,ERROR_BAD_BUFFER);
+    #endif
+    __atomic_store_n(&READER_SLOTS[target->slot].epoch,0,__ATOMIC_RELEASE);
+    target->version = NULL;
+}
+
+unsigned int get_snapshot_length(const snapshot* target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL || target->version == NULL,ERROR_BAD_BUFFER);
+    #endif
+    return ((const struct version*)target->version)->num_elements;
+}
+
+unsigned int get_snapshot_num_chunks(const snapshot* target)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL || target->version == NULL,ERROR_BAD_BUFFER);
+    #endif
+    return ((const struct version*)target->version)->num_chunks;
+}
+
+buffer get_snapshot_chunk(const snapshot* target, unsigned int chunk)
+{
+    #ifdef ERROR_CHECKING
+    error_if(target == NULL || target->version == NULL,ERROR_BAD_BUFFER);
+    error_if(chunk >= ((const struct version*)target->version)->num_chunks,ERROR_OUT_OF_BOUNDS_INDEX);
+    #endif
+    return ((const struct version*)target->version)->chunks[chunk]->elements;
 }
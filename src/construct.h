@@ -22,10 +22,82 @@ The so called buffers are opaque to the end user in addition to a lot of error c
  This is only intended for the source of the implementation, hence the otherwise opaque data type */
 #ifndef CONSTRUCT_IMPLEMENTATION
 typedef void* buffer;
+typedef void* ring;
+typedef void* appender;
+typedef void* versioned;
 #endif
 
-/* Enum with the supported types ("VOID" actually means void pointer and can also be used for nested buffers) */
-enum construct_types {UINT,INT,FLOAT,CHAR,UCHAR,VOID};
+/* Expands to "static inline" where the compiler supports it, used for the accessors defined in the headers */
+#if defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L)
+    #define CONSTRUCT_INLINE static inline
+#elif defined(__GNUC__)
+    #define CONSTRUCT_INLINE static __inline__
+#else
+    #define CONSTRUCT_INLINE static
+#endif
+
+/* Enum with the supported types ("VOID" actually means void pointer, "HALF" is a 16 bit float, read and written as float,
+ "NESTED" is a nested buffer (or NULL) the deep operations follow as a tree, so a buffer nested twice gets copied twice and cycles aren't supported,
+ "BIT" is a flag read and written as 0 or 1, all BIT fields of an element are packed together into bytes at its end,
+ "STR16" and "STR32" are strings of up to 15 and 31 chars stored inside the element, "STRING" is the id of a string in the interned string pool,
+ "DICT8" and "DICT16" are integers stored as 8 and 16 bit codes into a dictionary of up to 256 and 65536 distinct values (code 0 always standing for 0), read and written as long long) */
+enum construct_types {UINT,INT,FLOAT,CHAR,UCHAR,VOID,INT8,INT16,UINT16,INT64,UINT64,DOUBLE,HALF,BIT,STR16,STR32,STRING,DICT8,DICT16,NESTED,NUM_CONSTRUCT_TYPES};
+
+/* Returns the float the given 16 bit float stands for */
+CONSTRUCT_INLINE float half_to_float(unsigned short half)
+{
+    union { unsigned int bits; float value; } result;
+    unsigned int sign = (half & 0x8000u) << 16, exponent = (half >> 10) & 0x1f, mantissa = half & 0x3ff;
+    if (exponent == 0x1f)
+        result.bits = sign | 0x7f800000u | (mantissa << 13);
+    else if (exponent != 0)
+        result.bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else
+    {
+        result.value = mantissa * (1.0f / 16777216.0f);
+        result.bits |= sign;
+    }
+    return result.value;
+}
+/* Returns the given float rounded to the nearest 16 bit float (Too large values become infinity) */
+CONSTRUCT_INLINE unsigned short float_to_half(float value)
+{
+    union { unsigned int bits; float value; } source;
+    unsigned int sign, bits;
+    source.value = value;
+    sign = (source.bits >> 16) & 0x8000u;
+    bits = source.bits & 0x7fffffffu;
+    if (bits >= 0x47800000u)
+        return (unsigned short)(sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u));
+    if (bits < 0x38800000u)
+    {
+        source.bits = bits;
+        source.value += 0.5f;
+        return (unsigned short)(sign | (source.bits - 0x3f000000u));
+    }
+    bits += 0xc8000fffu + ((bits >> 13) & 1);
+    return (unsigned short)(sign | (bits >> 13));
+}
+/* Sets or clears the bits of mask in the byte holding a BIT field */
+CONSTRUCT_INLINE void set_bit_field(unsigned char* bits, unsigned int mask, unsigned int data)
+{
+    *bits = (unsigned char)(data ? *bits | mask : *bits & ~mask);
+}
+/* Errors with ERROR_LONG_STRING, for the inline string setters */
+void util_error_long_string();
+/* Copies data into an inline string field of the given capacity, zeroing the rest of it so equal strings have equal bytes (Erroring if data doesn't fit, where "ERROR_CHECKING" is defined) */
+CONSTRUCT_INLINE void set_string_field(char* dest, unsigned int capacity, const char* data)
+{
+    unsigned int i;
+    for (i = 0; i + 1 < capacity && data[i] != '\0'; i++)
+        dest[i] = data[i];
+    #ifdef ERROR_CHECKING
+    if (data[i] != '\0')
+        util_error_long_string();
+    #endif
+    for (; i < capacity; i++)
+        dest[i] = '\0';
+}
 
 /* <Todo> */
 void scramble_buffer(buffer target);
@@ -54,8 +126,10 @@ buffer init_buffer(unsigned int num_elements);
 buffer init_bufferva(unsigned int num_elements, unsigned int num_types, ...);
 /* Returns an initialised buffer with the given types and the specified length (doesn't clear the stack for the types) */
 buffer init_bufferve(unsigned int num_elements, unsigned int num_types, enum construct_types* types);
-/* Deinitialises the specified buffer by freeing the internal variables */
+/* Deinitialises the specified buffer by freeing the internal variables (Deinitialising a view only frees the view itself, not the viewed data) */
 void deinit_buffer(buffer target);
+/* Deinitialises the specified buffer and every buffer nested in its NESTED fields, recursively (A deep copy is freed in one go, just like deinit_buffer() does) */
+void deinit_buffer_deep(buffer target);
 /* Binds the specified buffer at the specified index */
 void bind_buffer_at(buffer target, unsigned int index);
 /* Returns the currently bound buffer */
@@ -65,6 +139,10 @@ buffer get_current_buffer();
 void sort_buffer_by_field(buffer target,unsigned int less,unsigned int field, enum construct_types type);
 /* Sorts the currently bound buffer in ascending or descending order by the specified field */
 void sort_by_field(unsigned int more,unsigned int field, enum construct_types type);
+/* Returns the field the specified buffer is known to ascend by, or (unsigned int)-1 (Sorting ascending sets it, writes through the library clear it, the inline setters don't) */
+unsigned int get_buffer_sorted_field(buffer target);
+/* Declares the specified buffer to be in ascending order of the given field, or of none for (unsigned int)-1 (Only declare orders that hold, join_buffer() trusts them) */
+void set_buffer_sorted_field(buffer target, unsigned int field);
 
 /* Reverses the sequence of elements in the specified buffer */
 void reverse_buffer(buffer target);
@@ -80,6 +158,16 @@ void resize(unsigned int num_elements);
 buffer copy_partial(unsigned int startidx, unsigned int endidx);
 /* Returns a buffer, initialised with a partition of the specified buffer within the given indices */
 buffer copy_partial_buffer(buffer target, unsigned int startidx, unsigned int endidx);
+/* Returns a view of the currently bound buffer, spanning the given number of elements from the start index (Views share its data and can't be resized, resizing it invalidates them!) */
+buffer view_partial(unsigned int startidx, unsigned int num_elements);
+/* Returns a view of the specified buffer, spanning the given number of elements from the start index (Views share its data and can't be resized, resizing it invalidates them!) */
+buffer view_partial_buffer(buffer target, unsigned int startidx, unsigned int num_elements);
+/* Returns a view of the specified buffer, spanning the given number of elements from the start index, skipping over step - 1 elements between each of them */
+buffer view_partial_buffer_strided(buffer target, unsigned int startidx, unsigned int num_elements, unsigned int step);
+/* Moves the specified view to span the given number of elements from the start index of the viewed buffer without allocating a new view */
+void move_view(buffer view, unsigned int startidx, unsigned int num_elements);
+/* Returns 1 if the specified buffer is a view of another buffer and 0 otherwise */
+unsigned int is_buffer_view(buffer target);
 /* Returns a buffer with a single element laid out according to the specified buffer */
 buffer create_single_buffer_element(buffer target);
 /* Returns a buffer with a single element laid out according to the currently bound buffer */
@@ -90,6 +178,11 @@ buffer recreate_buffer(buffer target);
 buffer recreate();
 /* Returns a preinitialised copy of the specified buffer */
 buffer copy_buffer(buffer src);
+/* Returns a copy of the specified buffer sharing its data until either is written to (The first write moves the data, invalidating pointers to it, buffers with live views are copied at once) */
+buffer copy_buffer_cow(buffer src);
+/* Returns a copy of the specified buffer and every buffer nested in its NESTED fields, recursively, all placed in one contiguous allocation
+ (Only the returned buffer can be deinitialised, which frees the whole tree at once, and none of the copied buffers can be resized or removed from) */
+buffer copy_buffer_deep(buffer src);
 /* Copys the contents of the currenty bound buffer into the specified buffer */
 void copy_to_buffer(buffer dest);
 /* Copys the contents of the specified buffer into the currenty bound buffer */
@@ -143,11 +236,15 @@ void load_binary(void* bin_data, unsigned int size);
 void* dump_buffer_binary(buffer target, unsigned int* size);
 /* Copies bin_data into the data buffer of the specified buffer and resizes it if the given size doesn't match the current size of the specified buffer */
 void load_buffer_binary(buffer target, void* bin_data, unsigned int size);
+/* Returns an already malloc'ed flat copy of the specified buffer, its types, dictionaries and nested buffers, recursively, and populates size with its length in bytes */
+void* dump_buffer_binary_deep(buffer target, unsigned int* size);
+/* Returns a new tree of buffers loaded from data dumped by dump_buffer_binary_deep(), in one allocation like copy_buffer_deep() (NULL if a buffer in it has no types) */
+buffer load_buffer_binary_deep(void* bin_data, unsigned int size);
 
 /* sets every single byte in the data buffer of the currently bound buffer to zero */
 void zero_out();
 /* Returns the size of the currently bound buffer's data buffer in bytes */
-unsigned int get_size(buffer target);
+unsigned int get_size();
 /* Returns the raw data buffer of the currently bound buffer */
 void* get_data_buffer();
 /* Returns the iterator of the currently bound buffer */
@@ -178,6 +275,216 @@ unsigned int get_buffer_element_size(buffer target);
 /* Returns the offset in bytes of the element at the given index in the specified buffer */
 unsigned int get_buffer_element_data_offset(buffer target, unsigned int index);
 
+/* Counters of the work done on buffers, only counted if the library was compiled with "CONSTRUCT_STATS" (otherwise they stay zero and cost nothing) */
+struct construct_stats
+{
+    unsigned long reallocs,bytes_copied,bytes_zeroed,sorts,comparisons,swaps;
+};
+
+/* Populates stats with the counters of the specified buffer */
+void get_buffer_stats(buffer target, struct construct_stats* stats);
+/* Populates stats with the counters summed over all buffers */
+void get_global_stats(struct construct_stats* stats);
+/* Resets the counters of the specified buffer to zero */
+void reset_buffer_stats(buffer target);
+/* Resets the counters summed over all buffers to zero */
+void reset_global_stats();
+
+/* Memory footprint of a live buffer, only tracked with "CONSTRUCT_REGISTRY" (Data shared between copy-on-write copies is split evenly between them, views don't own any data) */
+struct construct_footprint
+{
+    const char* file;
+    unsigned int line;
+    unsigned long data_bytes,type_bytes,header_bytes,slack_bytes,peak_bytes;
+};
+
+/* Returns the number of buffers which have been created and not yet deinitialised */
+unsigned int get_num_live_buffers();
+/* Returns the number of bytes all live buffers currently take and populates peak with the most they ever took at once (peak may be NULL) */
+unsigned long get_live_bytes(unsigned long* peak);
+/* Calls function with every live buffer and the given data, most recently created first (Don't create or deinitialise buffers from within function!) */
+void for_each_live_buffer(void (*function)(buffer target, void* data), void* data);
+/* Populates footprint with the memory the specified buffer takes and the call site it was created at */
+void get_buffer_footprint(buffer target, struct construct_footprint* footprint);
+/* Writes one line per live buffer to stream, sorted by the number of bytes they take from most to least */
+void dump_registry_report(FILE* stream);
+/* Writes the given number of call sites in the library spending the most time allocating to stream (0 writes all of them), only profiled if the library was compiled with "CONSTRUCT_PROFILE" */
+void dump_allocation_report(FILE* stream, unsigned int num_sites);
+/* Resets the counters of every allocating call site to zero (The realloc chains of live blocks keep growing from where they are) */
+void reset_allocation_profile();
+
+/* Records the call site of the next created buffer (The macros at the end of this header call it for you if "CONSTRUCT_REGISTRY" is defined) */
+void set_registry_call_site(const char* file, unsigned int line);
+
+/* Converts the given field of every element in the specified buffer into the given field of another buffer like a C cast would (Encoded fields convert from and to the integer types) */
+void convert_buffer_field(buffer src, unsigned int src_field, buffer dest, unsigned int dest_field);
+/* Converts one field of every element in the currently bound buffer into another one of its fields, like a C cast between the numeric types would */
+void convert_field(unsigned int src_field, unsigned int dest_field);
+
+/* Returns the number of elements in the specified buffer with the given BIT field set */
+unsigned int count_buffer_bits(buffer target, unsigned int field);
+/* Returns the number of elements in the currently bound buffer with the given BIT field set */
+unsigned int count_bits(unsigned int field);
+/* Sets bit i of mask (one bit per element, lowest bit first) if the given BIT fields of element i in the specified buffer have the given values (0 or 1), returns the number of matching elements
+ (mask needs room for (get_buffer_length(target) + CONSTRUCT_MASK_BITS - 1) / CONSTRUCT_MASK_BITS words) */
+unsigned int filter_buffer_bits(buffer target, unsigned int num_fields, const unsigned int* fields, const unsigned int* values, unsigned long* mask);
+/* Returns the number of set bits among the first num_bits bits of a mask produced by filter_buffer_bits() */
+unsigned int count_mask_bits(const unsigned long* mask, unsigned int num_bits);
+/* Returns the id of the given string in the interned string pool, adding it to the pool if it isn't in there yet (The empty string always has the id 0) */
+unsigned int intern_string(const char* data);
+/* Returns the id of the given string in the interned string pool, or (unsigned int)-1 if it isn't in there */
+unsigned int find_interned_string(const char* data);
+/* Returns the string with the given id in the interned string pool (It stays valid until the pool is cleared or replaced) */
+const char* get_interned_string(unsigned int id);
+/* Returns the number of strings in the interned string pool */
+unsigned int get_num_interned_strings();
+/* Frees the interned string pool, invalidating every id (Only do this if no buffer with a STRING field is still needed) */
+void clear_string_pool();
+/* Returns an already malloc'ed pointer to a flat copy of the interned string pool and populates size with its length in bytes */
+void* dump_string_pool_binary(unsigned int* size);
+/* Replaces the interned string pool with one dumped by dump_string_pool_binary(), so the ids stored in loaded buffers mean the same strings again */
+void load_string_pool_binary(void* bin_data, unsigned int size);
+
+/* Returns the code of the given encoded field of the specified buffer (Only buffers copied, recreated or viewed from one another share dictionaries, and so codes) */
+unsigned int get_buffer_code(buffer target, unsigned int element, unsigned int field);
+/* Returns the number of distinct values in the dictionary of the given encoded field of the specified buffer */
+unsigned int get_dictionary_size(buffer target, unsigned int field);
+/* Returns the value the given code stands for in the dictionary of the given encoded field of the specified buffer */
+long long get_dictionary_value(buffer target, unsigned int field, unsigned int code);
+/* Returns the code of the given value in the dictionary of the given encoded field of the specified buffer, or (unsigned int)-1 if it isn't in there */
+unsigned int find_dictionary_code(buffer target, unsigned int field, long long value);
+/* Sets bit i of mask if the given encoded field of element i in the specified buffer equals value, comparing codes, returns the number of matches (mask sized like for filter_buffer_bits()) */
+unsigned int filter_buffer_encoded(buffer target, unsigned int field, long long value, unsigned long* mask);
+
+/* The aggregates group_buffer_by() can compute over a field, into a UINT64 field for AGGREGATE_COUNT and a DOUBLE field for the others */
+enum construct_aggregate_ops {AGGREGATE_COUNT,AGGREGATE_SUM,AGGREGATE_MIN,AGGREGATE_MAX,AGGREGATE_MEAN};
+/* One aggregate column of group_buffer_by() (field is ignored for AGGREGATE_COUNT) */
+struct construct_aggregate
+{
+    enum construct_aggregate_ops op;
+    unsigned int field;
+};
+/* Returns a new buffer with one element per distinct combination of the given key fields, holding them and the given aggregates (Grouped by value, in parallel if num_threads > 1) */
+buffer group_buffer_by(buffer src, unsigned int num_keys, const unsigned int* key_fields, unsigned int num_aggregates, const struct construct_aggregate* aggregates, unsigned int num_threads);
+/* Returns a new buffer grouping the currently bound buffer like group_buffer_by() does */
+buffer group_by(unsigned int num_keys, const unsigned int* key_fields, unsigned int num_aggregates, const struct construct_aggregate* aggregates, unsigned int num_threads);
+
+/* The kinds of joins join_buffer() can do, a left join keeps every left element and marks whether it found a match in a trailing BIT field */
+enum construct_join_kinds {JOIN_INNER,JOIN_LEFT};
+/* Returns a new buffer pairing the elements of left and right with equal key fields, fields of left first (Left joins zero right for unmatched ones, -0.0 matches 0.0, NaN nothing) */
+buffer join_buffer(buffer left, unsigned int left_field, buffer right, unsigned int right_field, enum construct_join_kinds kind);
+/* Returns a new buffer joining the currently bound buffer as the left side with right like join_buffer() does */
+buffer join(unsigned int left_field, buffer right, unsigned int right_field, enum construct_join_kinds kind);
+
+/* Returns a new buffer with the k smallest (or largest if descending) elements of the specified buffer by the given field in that order, equal elements keep their order (O(n log k)) */
+buffer top_buffer_k(buffer src, unsigned int field, unsigned int k, unsigned int descending);
+/* Returns a new buffer with a single UINT field holding the indices of the elements top_buffer_k() would return, in the same order */
+buffer top_buffer_k_indices(buffer src, unsigned int field, unsigned int k, unsigned int descending);
+/* Reorders the specified buffer so its first k elements are its k smallest (or largest if descending) by the given field in that order, the rest in no particular order (O(n + k log k)) */
+void partial_sort_buffer(buffer target, unsigned int field, unsigned int k, unsigned int descending);
+/* Reorders the specified buffer so element nth is the one a sort by the given field would put there, with no element before it coming after it in that order and vice versa (Introselect, O(n)) */
+void nth_element_buffer(buffer target, unsigned int field, unsigned int nth, unsigned int descending);
+/* Returns a new buffer with the k smallest (or largest if descending) elements of the currently bound buffer like top_buffer_k() does */
+buffer top_k(unsigned int field, unsigned int k, unsigned int descending);
+/* Returns a new buffer with the indices of the elements top_k() would return */
+buffer top_k_indices(unsigned int field, unsigned int k, unsigned int descending);
+/* Reorders the currently bound buffer like partial_sort_buffer() does */
+void partial_sort(unsigned int field, unsigned int k, unsigned int descending);
+/* Reorders the currently bound buffer like nth_element_buffer() does */
+void nth_element(unsigned int field, unsigned int nth, unsigned int descending);
+
+/* Returns a new buffer with the first element of every distinct combination of the given key fields in the specified buffer, in order (-0.0 equals 0.0 and NaN equals NaN) */
+buffer distinct_buffer(buffer src, unsigned int num_keys, const unsigned int* key_fields);
+/* Removes every element of the specified buffer whose key fields equal those of an earlier element, compacting the rest in one pass, returns the number of elements left */
+unsigned int dedup_buffer_in_place(buffer target, unsigned int num_keys, const unsigned int* key_fields);
+/* Returns a new buffer with the distinct elements of the currently bound buffer like distinct_buffer() does */
+buffer distinct(unsigned int num_keys, const unsigned int* key_fields);
+/* Removes the duplicate elements of the currently bound buffer like dedup_buffer_in_place() does */
+unsigned int dedup_in_place(unsigned int num_keys, const unsigned int* key_fields);
+
+/* Called by parallel_for_buffer() for every block of count elements starting at element start, data points at that element and stride is the number of bytes to the next one */
+typedef void (*construct_range_function)(void* data, unsigned int start, unsigned int count, unsigned int stride, void* user);
+/* Replaces the thread pool with one of num_threads threads, the calling thread counting as one and 0 as 1 (Without "CONSTRUCT_THREADS" everything runs on the calling thread) */
+void init_thread_pool(unsigned int num_threads);
+/* Stops and joins the threads of the thread pool, the next parallel operation starts a new one (Don't call it while parallel operations are running) */
+void deinit_thread_pool();
+/* Returns the number of threads of the thread pool, starting one thread per online CPU if there isn't one yet */
+unsigned int get_thread_pool_size();
+/* Calls function for blocks of grain elements (CONSTRUCT_PARALLEL_GRAIN if 0) of the specified buffer on the thread pool and waits for them (It may be called from inside function) */
+void parallel_for_buffer(buffer target, construct_range_function function, unsigned int grain, void* user);
+/* Calls function for blocks of the currently bound buffer like parallel_for_buffer() does */
+void parallel_for(construct_range_function function, unsigned int grain, void* user);
+/* Tasks spawned with construct_spawn() into the same group are waited for together by construct_sync() (Start with a zeroed group, e.g. CONSTRUCT_TASK_GROUP_INIT) */
+struct construct_task_group
+{
+    unsigned int pending;
+};
+#define CONSTRUCT_TASK_GROUP_INIT {0}
+/* A task spawned with construct_spawn(), called with the range of elements of target (which may be NULL) it was spawned for */
+typedef void (*construct_task_function)(buffer target, unsigned int start, unsigned int count, void* user);
+/* Pushes a task onto the deque of the calling thread for any thread of the thread pool to run, tasks may spawn more tasks into any group (Runs it right away if the pool has a single thread) */
+void construct_spawn(struct construct_task_group* group, construct_task_function function, buffer target, unsigned int start, unsigned int count, void* user);
+/* Returns once every task spawned into the group has finished, running its own and stealing other tasks meanwhile */
+void construct_sync(struct construct_task_group* group);
+
+/* The kinds of rings init_ring() can create, for one producer and one consumer thread or any number of both */
+enum construct_ring_kinds {RING_SPSC,RING_MPMC};
+/* Returns a lock-free bounded queue of elements with the schema of the specified buffer and room for capacity of them, rounded up to a power of two (The schema can't have encoded fields) */
+ring init_ring(unsigned int capacity, buffer schema, enum construct_ring_kinds kind);
+/* Frees the specified ring and the elements still in it */
+void deinit_ring(ring target);
+/* Copies up to num_elements elements of the specified buffer starting at index into the ring, returns how many fit (Stage single elements with create_single_buffer_element()) */
+unsigned int push_ring(ring target, buffer src, unsigned int index, unsigned int num_elements);
+/* Moves up to num_elements elements out of the ring into the specified buffer starting at index, returns how many there were */
+unsigned int pop_ring(ring target, buffer dest, unsigned int index, unsigned int num_elements);
+/* Returns the number of elements in the specified ring (Only a snapshot while other threads use it) */
+unsigned int get_ring_length(ring target);
+/* Returns the number of elements the specified ring has room for */
+unsigned int get_ring_capacity(ring target);
+
+/* Returns a fixed capacity of elements with the schema of the specified buffer that any number of threads can append to at once, reserving their slots with an atomic add */
+appender init_appender(unsigned int capacity, buffer schema);
+/* Frees the specified appender and the elements appended to it */
+void deinit_appender(appender target);
+/* Copies num_elements elements of the specified buffer starting at index behind those other threads appended, returns how many fit (Threads' buffers can't share dictionaries) */
+unsigned int append_concurrent(appender target, buffer src, unsigned int index, unsigned int num_elements);
+/* Returns the number of elements appended to the specified appender so far (Only a snapshot while other threads append) */
+unsigned int get_appender_length(appender target);
+/* Frees the specified appender and returns a regular buffer of the elements appended to it, without copying them (Waits for appends still copying, but no new ones may start) */
+buffer seal_appender(appender target);
+
+/* A version of a versioned buffer pinned by a reader, which stays readable until it's unpinned no matter what the writer publishes meanwhile */
+typedef struct construct_snapshot
+{
+    void* version;
+    unsigned int slot;
+} snapshot;
+/* Returns a copy of the specified buffer split into chunks of chunk_elements elements, which one writer updates chunk by chunk while any number of readers pin consistent versions */
+versioned init_versioned(buffer src, unsigned int chunk_elements);
+/* Frees the specified versioned buffer and all of its versions (No reader may have one pinned anymore) */
+void deinit_versioned(versioned target);
+/* Returns the number of chunks of the specified versioned buffer */
+unsigned int get_versioned_num_chunks(versioned target);
+/* Returns the writer's copy of the given chunk for the next version, copying it from the current version on the first write since the last publish (Only the writer thread may call it) */
+buffer write_versioned_chunk(versioned target, unsigned int chunk);
+/* Makes the chunks written since the last publish visible to readers pinning from now on, and frees the versions no reader has pinned anymore (Only the writer thread may call it) */
+void publish_versioned(versioned target);
+/* Pins the current version of the specified versioned buffer for the calling thread without locking, at most CONSTRUCT_MAX_READERS (64) snapshots may be pinned at once */
+void pin_snapshot(snapshot* target, versioned src);
+/* Unpins the version of the specified snapshot, letting the writer free it once it's no longer the current one */
+void unpin_snapshot(snapshot* target);
+/* Returns the number of elements in all chunks of the pinned version */
+unsigned int get_snapshot_length(const snapshot* target);
+/* Returns the number of chunks of the pinned version */
+unsigned int get_snapshot_num_chunks(const snapshot* target);
+/* Returns the given chunk of the pinned version (Only read from it with the get_buffer_field functions, it may be shared with other readers and versions) */
+buffer get_snapshot_chunk(const snapshot* target, unsigned int chunk);
+
+/* Number of bits in every word of a mask produced by filter_buffer_bits() */
+#define CONSTRUCT_MASK_BITS (sizeof(unsigned long) * 8)
+/* Returns whether bit i of a mask produced by filter_buffer_bits() is set */
+#define test_mask_bit(mask,i) (((mask)[(i) / CONSTRUCT_MASK_BITS] >> ((i) % CONSTRUCT_MASK_BITS)) & 1ul)
+
 /* Multiplies and stores the result of the used operation with the given field in the currently bound buffer and the factor */
 void mul_field(unsigned int field, float factor);
 void div_field(unsigned int field, float factor);
@@ -197,6 +504,18 @@ void set_fieldf(unsigned int field,  	float 			data);
 void set_fieldc(unsigned int field,  	char 			data);
 void set_fielduc(unsigned int field, 	unsigned char 	data);
 void set_fieldv(unsigned int field,		void* 			data);
+void set_fieldi8(unsigned int field, signed char data);
+void set_fieldi16(unsigned int field, short data);
+void set_fieldui16(unsigned int field, unsigned short data);
+void set_fieldi64(unsigned int field, long long data);
+void set_fieldui64(unsigned int field, unsigned long long data);
+void set_fieldd(unsigned int field, double data);
+void set_fieldh(unsigned int field, float data);
+void set_fieldb(unsigned int field, unsigned int data);
+void set_fields(unsigned int field, const char* data);
+void set_fieldp(unsigned int field, const char* data);
+void set_fieldn(unsigned int field, buffer data);
+void set_fielde(unsigned int field, long long data);
 /* Returns the given field of the currently bound buffer */
 unsigned int	get_fieldui(unsigned int field);
 int 			get_fieldi(unsigned int field);
@@ -204,6 +523,18 @@ float 			get_fieldf(unsigned int field);
 char 			get_fieldc(unsigned int field);
 unsigned char 	get_fielduc(unsigned int field);
 void* 			get_fieldv(unsigned int field);
+signed char     get_fieldi8(unsigned int field);
+short           get_fieldi16(unsigned int field);
+unsigned short  get_fieldui16(unsigned int field);
+long long       get_fieldi64(unsigned int field);
+unsigned long long get_fieldui64(unsigned int field);
+double          get_fieldd(unsigned int field);
+float           get_fieldh(unsigned int field);
+unsigned int    get_fieldb(unsigned int field);
+const char*     get_fields(unsigned int field);
+const char*     get_fieldp(unsigned int field);
+buffer          get_fieldn(unsigned int field);
+long long       get_fielde(unsigned int field);
 /* Returns a generic void pointer to the given field of the currently bound buffer (If a buffer gets resized, it invalidates all previously obtained pointers to it!) */
 void*           get_pointer(unsigned int field);
 /* Returns a pointer to the first field of the currently bound buffer (If a buffer gets resized, it invalidates all previously obtained pointers to it!) */
@@ -215,6 +546,13 @@ float* 			get_pointerf(unsigned int field);
 char* 			get_pointerc(unsigned int field);
 unsigned char* 	get_pointeruc(unsigned int field);
 void**          get_pointerv(unsigned int field);
+signed char*    get_pointeri8(unsigned int field);
+short*          get_pointeri16(unsigned int field);
+unsigned short* get_pointerui16(unsigned int field);
+long long*      get_pointeri64(unsigned int field);
+unsigned long long* get_pointerui64(unsigned int field);
+double*         get_pointerd(unsigned int field);
+unsigned short* get_pointerh(unsigned int field);
 
 /* Assigns the given field of the specified buffer to the specified data */
 void set_buffer_fieldui(buffer target, unsigned int element, unsigned int field,	unsigned int 	data);
@@ -223,6 +561,20 @@ void set_buffer_fieldf(buffer target, unsigned int element, unsigned int field,
 void set_buffer_fieldc(buffer target, unsigned int element, unsigned int field,		char 			data);
 void set_buffer_fielduc(buffer target, unsigned int element, unsigned int field,	unsigned char 	data);
 void set_buffer_fieldv(buffer target, unsigned int element, unsigned int field,		void* 			data);
+void set_buffer_fieldi8(buffer target, unsigned int element, unsigned int field, signed char data);
+void set_buffer_fieldi16(buffer target, unsigned int element, unsigned int field, short data);
+void set_buffer_fieldui16(buffer target, unsigned int element, unsigned int field, unsigned short data);
+void set_buffer_fieldi64(buffer target, unsigned int element, unsigned int field, long long data);
+void set_buffer_fieldui64(buffer target, unsigned int element, unsigned int field, unsigned long long data);
+void set_buffer_fieldd(buffer target, unsigned int element, unsigned int field, double data);
+void set_buffer_fieldh(buffer target, unsigned int element, unsigned int field, float data);
+void set_buffer_fieldb(buffer target, unsigned int element, unsigned int field, unsigned int data);
+void set_buffer_fields(buffer target, unsigned int element, unsigned int field, const char* data);
+void set_buffer_fieldp(buffer target, unsigned int element, unsigned int field, const char* data);
+void set_buffer_fieldn(buffer target, unsigned int element, unsigned int field, buffer data);
+void set_buffer_fielde(buffer target, unsigned int element, unsigned int field, long long data);
+/* Assigns the given STRING field of the specified buffer to the string with the given id in the interned string pool */
+void set_buffer_string_id(buffer target, unsigned int element, unsigned int field, unsigned int id);
 /* Returns the given field of the specified buffer */
 unsigned int	get_buffer_fieldui(buffer target, unsigned int element, unsigned int field);
 int 			get_buffer_fieldi(buffer target, unsigned int element, unsigned int field);
@@ -230,6 +582,34 @@ float 			get_buffer_fieldf(buffer target, unsigned int element, unsigned int fie
 char 			get_buffer_fieldc(buffer target, unsigned int element, unsigned int field);
 unsigned char 	get_buffer_fielduc(buffer target, unsigned int element, unsigned int field);
 void* 			get_buffer_fieldv(buffer target, unsigned int element, unsigned int field);
+signed char     get_buffer_fieldi8(buffer target, unsigned int element, unsigned int field);
+short           get_buffer_fieldi16(buffer target, unsigned int element, unsigned int field);
+unsigned short  get_buffer_fieldui16(buffer target, unsigned int element, unsigned int field);
+long long       get_buffer_fieldi64(buffer target, unsigned int element, unsigned int field);
+unsigned long long get_buffer_fieldui64(buffer target, unsigned int element, unsigned int field);
+double          get_buffer_fieldd(buffer target, unsigned int element, unsigned int field);
+float           get_buffer_fieldh(buffer target, unsigned int element, unsigned int field);
+unsigned int    get_buffer_fieldb(buffer target, unsigned int element, unsigned int field);
+const char*     get_buffer_fields(buffer target, unsigned int element, unsigned int field);
+const char*     get_buffer_fieldp(buffer target, unsigned int element, unsigned int field);
+buffer          get_buffer_fieldn(buffer target, unsigned int element, unsigned int field);
+long long       get_buffer_fielde(buffer target, unsigned int element, unsigned int field);
+/* Returns the id of the given STRING field of the specified buffer in the interned string pool, so equal strings can be compared as integers */
+unsigned int    get_buffer_string_id(buffer target, unsigned int element, unsigned int field);
+
+/* Copies the packed fields of one element (laid out exactly like an element of the currently bound buffer) into the currently bound buffer */
+void set_element(const void* data);
+/* Copies the fields of the currently bound buffer's element into data as one packed element */
+void get_element(void* data);
+/* Copies the packed fields of one element (laid out exactly like an element of the specified buffer) into the specified buffer at the given element */
+void set_buffer_element(buffer target, unsigned int element, const void* data);
+/* Copies the fields of the given element of the specified buffer into data as one packed element */
+void get_buffer_element(buffer target, unsigned int element, void* data);
+/* Copies the given number of structs of src_size bytes each into the specified buffer starting at index, growing the buffer if needed
+ offsets holds the offset of every field inside the struct (offsetof()), or NULL if the structs are packed exactly like the buffer's elements */
+void import_buffer_elements(buffer target, unsigned int index, const void* src, unsigned int num_elements, unsigned int src_size, const unsigned int* offsets);
+/* Copies the given number of elements of the specified buffer starting at index into structs of dest_size bytes each, using the same offsets as import_buffer_elements() */
+void export_buffer_elements(buffer target, unsigned int index, void* dest, unsigned int num_elements, unsigned int dest_size, const unsigned int* offsets);
 /* Returns a generic void pointer to the given field of the given element of the specified buffer (If a buffer gets resized, it invalidates all previously obtained pointers to it!) */
 void*           get_buffer_pointer(buffer target, unsigned int element, unsigned int field);
 /* Returns a pointer to the first field of the given element in the specified buffer (If a buffer gets resized, it invalidates all previously obtained pointers to it!) */
@@ -241,6 +621,205 @@ float* 			get_buffer_pointerf(buffer target, unsigned int element, unsigned int
 char* 			get_buffer_pointerc(buffer target, unsigned int element, unsigned int field);
 unsigned char* 	get_buffer_pointeruc(buffer target, unsigned int element, unsigned int field);
 void**          get_buffer_pointerv(buffer target, unsigned int element, unsigned int field);
+signed char*    get_buffer_pointeri8(buffer target, unsigned int element, unsigned int field);
+short*          get_buffer_pointeri16(buffer target, unsigned int element, unsigned int field);
+unsigned short* get_buffer_pointerui16(buffer target, unsigned int element, unsigned int field);
+long long*      get_buffer_pointeri64(buffer target, unsigned int element, unsigned int field);
+unsigned long long* get_buffer_pointerui64(buffer target, unsigned int element, unsigned int field);
+double*         get_buffer_pointerd(buffer target, unsigned int element, unsigned int field);
+unsigned short* get_buffer_pointerh(buffer target, unsigned int element, unsigned int field);
+
+/* Maximum number of fields a cursor caches the offsets of */
+#define CONSTRUCT_MAX_CURSOR_FIELDS 32
+
+/* A cursor walks over the elements of a buffer with the schema checks and the offset calculations done once when opening it,
+ so the accessors below are nothing but pointer arithmetic. It's not opaque, in order for the accessors to be inlined into the loops using them.
+ masks holds the bit of every BIT field and the capacity of every STR16/STR32 field (If the buffer gets resized, it invalidates all cursors opened on it!) */
+typedef struct construct_cursor
+{
+    unsigned char* data;
+    unsigned char* element;
+    unsigned int stride,index,num_elements,num_fields;
+    unsigned int offsets[CONSTRUCT_MAX_CURSOR_FIELDS];
+    unsigned int masks[CONSTRUCT_MAX_CURSOR_FIELDS];
+} cursor;
+
+/* Opens a cursor over the currently bound buffer, checking that its first num_fields fields have the given types (types may be NULL to skip the type checks) */
+void open_cursor(cursor* target, unsigned int num_fields, const enum construct_types* types);
+/* Opens a cursor over the specified buffer, checking that its first num_fields fields have the given types (types may be NULL to skip the checks, at most CONSTRUCT_MAX_CURSOR_FIELDS) */
+void open_buffer_cursor(cursor* target, buffer src, unsigned int num_fields, const enum construct_types* types);
+
+/* Advances the cursor to the next element, returns 0 and rewinds the cursor once all elements have been visited */
+CONSTRUCT_INLINE unsigned int cursor_next(cursor* target)
+{
+    if (++target->index >= target->num_elements)
+    {
+        target->index = -1;
+        return 0;
+    }
+    target->element = target->data + target->stride * target->index;
+    return 1;
+}
+/* Moves the cursor to the given element */
+CONSTRUCT_INLINE void cursor_seek(cursor* target, unsigned int index)
+{
+    target->index = index;
+    target->element = target->data + target->stride * index;
+}
+
+/* Returns a pointer to the given field of the cursor's current element */
+CONSTRUCT_INLINE void*          cursor_pointer(cursor* target, unsigned int field)   { return target->element + target->offsets[field]; }
+CONSTRUCT_INLINE unsigned int*  cursor_pointerui(cursor* target, unsigned int field) { return (unsigned int*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE int*           cursor_pointeri(cursor* target, unsigned int field)  { return (int*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE float*         cursor_pointerf(cursor* target, unsigned int field)  { return (float*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE char*          cursor_pointerc(cursor* target, unsigned int field)  { return (char*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE unsigned char* cursor_pointeruc(cursor* target, unsigned int field) { return (unsigned char*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE void**         cursor_pointerv(cursor* target, unsigned int field)  { return (void**)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE signed char*        cursor_pointeri8(cursor* target, unsigned int field)    { return (signed char*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE short*              cursor_pointeri16(cursor* target, unsigned int field)   { return (short*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE unsigned short*     cursor_pointerui16(cursor* target, unsigned int field)  { return (unsigned short*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE long long*          cursor_pointeri64(cursor* target, unsigned int field)   { return (long long*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE unsigned long long* cursor_pointerui64(cursor* target, unsigned int field)  { return (unsigned long long*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE double*             cursor_pointerd(cursor* target, unsigned int field)     { return (double*)(target->element + target->offsets[field]); }
+CONSTRUCT_INLINE unsigned short*     cursor_pointerh(cursor* target, unsigned int field)     { return (unsigned short*)(target->element + target->offsets[field]); }
+
+/* Returns the given field of the cursor's current element */
+CONSTRUCT_INLINE unsigned int   cursor_fieldui(cursor* target, unsigned int field) { return *cursor_pointerui(target,field); }
+CONSTRUCT_INLINE int            cursor_fieldi(cursor* target, unsigned int field)  { return *cursor_pointeri(target,field); }
+CONSTRUCT_INLINE float          cursor_fieldf(cursor* target, unsigned int field)  { return *cursor_pointerf(target,field); }
+CONSTRUCT_INLINE char           cursor_fieldc(cursor* target, unsigned int field)  { return *cursor_pointerc(target,field); }
+CONSTRUCT_INLINE unsigned char  cursor_fielduc(cursor* target, unsigned int field) { return *cursor_pointeruc(target,field); }
+CONSTRUCT_INLINE void*          cursor_fieldv(cursor* target, unsigned int field)  { return *cursor_pointerv(target,field); }
+CONSTRUCT_INLINE signed char         cursor_fieldi8(cursor* target, unsigned int field)    { return *cursor_pointeri8(target,field); }
+CONSTRUCT_INLINE short               cursor_fieldi16(cursor* target, unsigned int field)   { return *cursor_pointeri16(target,field); }
+CONSTRUCT_INLINE unsigned short      cursor_fieldui16(cursor* target, unsigned int field)  { return *cursor_pointerui16(target,field); }
+CONSTRUCT_INLINE long long           cursor_fieldi64(cursor* target, unsigned int field)   { return *cursor_pointeri64(target,field); }
+CONSTRUCT_INLINE unsigned long long  cursor_fieldui64(cursor* target, unsigned int field)  { return *cursor_pointerui64(target,field); }
+CONSTRUCT_INLINE double              cursor_fieldd(cursor* target, unsigned int field)     { return *cursor_pointerd(target,field); }
+CONSTRUCT_INLINE float               cursor_fieldh(cursor* target, unsigned int field)     { return half_to_float(*cursor_pointerh(target,field)); }
+CONSTRUCT_INLINE unsigned int        cursor_fieldb(cursor* target, unsigned int field)     { return (*cursor_pointeruc(target,field) & target->masks[field]) != 0; }
+CONSTRUCT_INLINE const char*         cursor_fields(cursor* target, unsigned int field)     { return (const char*)cursor_pointer(target,field); }
+CONSTRUCT_INLINE const char*         cursor_fieldp(cursor* target, unsigned int field)     { return get_interned_string(*cursor_pointerui(target,field)); }
+
+/* Assigns the given field of the cursor's current element to the specified data */
+CONSTRUCT_INLINE void cursor_set_fieldui(cursor* target, unsigned int field, unsigned int data)  { *cursor_pointerui(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldi(cursor* target, unsigned int field, int data)            { *cursor_pointeri(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldf(cursor* target, unsigned int field, float data)          { *cursor_pointerf(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldc(cursor* target, unsigned int field, char data)           { *cursor_pointerc(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fielduc(cursor* target, unsigned int field, unsigned char data) { *cursor_pointeruc(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldv(cursor* target, unsigned int field, void* data)          { *cursor_pointerv(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldi8(cursor* target, unsigned int field, signed char data)    { *cursor_pointeri8(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldi16(cursor* target, unsigned int field, short data)         { *cursor_pointeri16(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldui16(cursor* target, unsigned int field, unsigned short data) { *cursor_pointerui16(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldi64(cursor* target, unsigned int field, long long data)     { *cursor_pointeri64(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldui64(cursor* target, unsigned int field, unsigned long long data) { *cursor_pointerui64(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldd(cursor* target, unsigned int field, double data)          { *cursor_pointerd(target,field) = data; }
+CONSTRUCT_INLINE void cursor_set_fieldh(cursor* target, unsigned int field, float data)           { *cursor_pointerh(target,field) = float_to_half(data); }
+CONSTRUCT_INLINE void cursor_set_fieldb(cursor* target, unsigned int field, unsigned int data)    { set_bit_field(cursor_pointeruc(target,field),target->masks[field],data); }
+CONSTRUCT_INLINE void cursor_set_fields(cursor* target, unsigned int field, const char* data)     { set_string_field(cursor_pointerc(target,field),target->masks[field],data); }
+CONSTRUCT_INLINE void cursor_set_fieldp(cursor* target, unsigned int field, const char* data)     { *cursor_pointerui(target,field) = intern_string(data); }
+
+/* A batch checks the schema and bounds of a buffer once when it begins, so its accessors don't have to (Unless "NDEBUG" is defined, they assert them and that the buffer is unchanged) */
+typedef struct construct_batch
+{
+    unsigned char* data;
+    buffer src;
+    void* const* src_data;
+    const unsigned int* src_num_elements;
+    unsigned int* const* src_references;
+    unsigned int stride,num_elements,num_fields,open;
+    unsigned int offsets[CONSTRUCT_MAX_CURSOR_FIELDS];
+    unsigned int masks[CONSTRUCT_MAX_CURSOR_FIELDS];
+    enum construct_types types[CONSTRUCT_MAX_CURSOR_FIELDS];
+} batch;
+
+/* Begins a batch over the specified buffer, checking that the given fields have the given types (types may be NULL to skip the type checks, the accessors address fields by position) */
+void begin_batch(batch* target, buffer src, unsigned int num_fields, const unsigned int* fields, const enum construct_types* types);
+/* Ends the batch, erroring if its buffer has been resized, moved or shared since it began */
+void end_batch(batch* target);
+/* Returns 1 if the batch is open and the data of its buffer hasn't been resized, moved or shared since it began and 0 otherwise */
+unsigned int is_batch_valid(const batch* target);
+
+#ifdef NDEBUG
+    #define CONSTRUCT_BATCH_ASSERT(target,element,slot,type)
+#else
+    #include <assert.h>
+    #define CONSTRUCT_BATCH_ASSERT(target,element,slot,type) assert((target)->open && *(target)->src_data == (target)->data && *(target)->src_num_elements == (target)->num_elements && *(target)->src_references == NULL \
+        && (element) < (target)->num_elements && (slot) < (target)->num_fields && (target)->types[slot] == (type))
+#endif
+
+/* Returns a pointer to the field at the given position of the given element in the batch */
+CONSTRUCT_INLINE void* batch_pointer(batch* target, unsigned int element, unsigned int slot)
+{
+    return target->data + target->stride * element + target->offsets[slot];
+}
+
+/* Returns the field at the given position of the given element in the batch */
+CONSTRUCT_INLINE unsigned int   batch_get_fieldui(batch* target, unsigned int element, unsigned int slot) { CONSTRUCT_BATCH_ASSERT(target,element,slot,UINT);  return *(unsigned int*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE int            batch_get_fieldi(batch* target, unsigned int element, unsigned int slot)  { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT);   return *(int*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE float          batch_get_fieldf(batch* target, unsigned int element, unsigned int slot)  { CONSTRUCT_BATCH_ASSERT(target,element,slot,FLOAT); return *(float*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE char           batch_get_fieldc(batch* target, unsigned int element, unsigned int slot)  { CONSTRUCT_BATCH_ASSERT(target,element,slot,CHAR);  return *(char*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE unsigned char  batch_get_fielduc(batch* target, unsigned int element, unsigned int slot) { CONSTRUCT_BATCH_ASSERT(target,element,slot,UCHAR); return *(unsigned char*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE void*          batch_get_fieldv(batch* target, unsigned int element, unsigned int slot)  { CONSTRUCT_BATCH_ASSERT(target,element,slot,VOID);  return *(void**)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE signed char         batch_get_fieldi8(batch* target, unsigned int element, unsigned int slot)     { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT8); return *(signed char*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE short               batch_get_fieldi16(batch* target, unsigned int element, unsigned int slot)    { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT16); return *(short*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE unsigned short      batch_get_fieldui16(batch* target, unsigned int element, unsigned int slot)   { CONSTRUCT_BATCH_ASSERT(target,element,slot,UINT16); return *(unsigned short*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE long long           batch_get_fieldi64(batch* target, unsigned int element, unsigned int slot)    { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT64); return *(long long*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE unsigned long long  batch_get_fieldui64(batch* target, unsigned int element, unsigned int slot)   { CONSTRUCT_BATCH_ASSERT(target,element,slot,UINT64); return *(unsigned long long*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE double              batch_get_fieldd(batch* target, unsigned int element, unsigned int slot)      { CONSTRUCT_BATCH_ASSERT(target,element,slot,DOUBLE); return *(double*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE float               batch_get_fieldh(batch* target, unsigned int element, unsigned int slot)      { CONSTRUCT_BATCH_ASSERT(target,element,slot,HALF); return half_to_float(*(unsigned short*)batch_pointer(target,element,slot)); }
+CONSTRUCT_INLINE unsigned int        batch_get_fieldb(batch* target, unsigned int element, unsigned int slot)      { CONSTRUCT_BATCH_ASSERT(target,element,slot,BIT); return (*(unsigned char*)batch_pointer(target,element,slot) & target->masks[slot]) != 0; }
+CONSTRUCT_INLINE const char*         batch_get_fields(batch* target, unsigned int element, unsigned int slot)      { CONSTRUCT_BATCH_ASSERT(target,element,slot,target->types[slot] == STR32 ? STR32 : STR16); return (const char*)batch_pointer(target,element,slot); }
+CONSTRUCT_INLINE const char*         batch_get_fieldp(batch* target, unsigned int element, unsigned int slot)      { CONSTRUCT_BATCH_ASSERT(target,element,slot,STRING); return get_interned_string(*(unsigned int*)batch_pointer(target,element,slot)); }
+
+/* Assigns the field at the given position of the given element in the batch to the specified data */
+CONSTRUCT_INLINE void batch_set_fieldui(batch* target, unsigned int element, unsigned int slot, unsigned int data)  { CONSTRUCT_BATCH_ASSERT(target,element,slot,UINT);  *(unsigned int*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldi(batch* target, unsigned int element, unsigned int slot, int data)            { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT);   *(int*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldf(batch* target, unsigned int element, unsigned int slot, float data)          { CONSTRUCT_BATCH_ASSERT(target,element,slot,FLOAT); *(float*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldc(batch* target, unsigned int element, unsigned int slot, char data)           { CONSTRUCT_BATCH_ASSERT(target,element,slot,CHAR);  *(char*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fielduc(batch* target, unsigned int element, unsigned int slot, unsigned char data) { CONSTRUCT_BATCH_ASSERT(target,element,slot,UCHAR); *(unsigned char*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldv(batch* target, unsigned int element, unsigned int slot, void* data)          { CONSTRUCT_BATCH_ASSERT(target,element,slot,VOID);  *(void**)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldi8(batch* target, unsigned int element, unsigned int slot, signed char data)      { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT8); *(signed char*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldi16(batch* target, unsigned int element, unsigned int slot, short data)           { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT16); *(short*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldui16(batch* target, unsigned int element, unsigned int slot, unsigned short data) { CONSTRUCT_BATCH_ASSERT(target,element,slot,UINT16); *(unsigned short*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldi64(batch* target, unsigned int element, unsigned int slot, long long data)       { CONSTRUCT_BATCH_ASSERT(target,element,slot,INT64); *(long long*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldui64(batch* target, unsigned int element, unsigned int slot, unsigned long long data) { CONSTRUCT_BATCH_ASSERT(target,element,slot,UINT64); *(unsigned long long*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldd(batch* target, unsigned int element, unsigned int slot, double data)            { CONSTRUCT_BATCH_ASSERT(target,element,slot,DOUBLE); *(double*)batch_pointer(target,element,slot) = data; }
+CONSTRUCT_INLINE void batch_set_fieldh(batch* target, unsigned int element, unsigned int slot, float data)             { CONSTRUCT_BATCH_ASSERT(target,element,slot,HALF); *(unsigned short*)batch_pointer(target,element,slot) = float_to_half(data); }
+CONSTRUCT_INLINE void batch_set_fieldb(batch* target, unsigned int element, unsigned int slot, unsigned int data)      { CONSTRUCT_BATCH_ASSERT(target,element,slot,BIT); set_bit_field((unsigned char*)batch_pointer(target,element,slot),target->masks[slot],data); }
+CONSTRUCT_INLINE void batch_set_fields(batch* target, unsigned int element, unsigned int slot, const char* data)       { CONSTRUCT_BATCH_ASSERT(target,element,slot,target->types[slot] == STR32 ? STR32 : STR16); set_string_field((char*)batch_pointer(target,element,slot),target->types[slot] == STR32 ? 32 : 16,data); }
+CONSTRUCT_INLINE void batch_set_fieldp(batch* target, unsigned int element, unsigned int slot, const char* data)       { CONSTRUCT_BATCH_ASSERT(target,element,slot,STRING); *(unsigned int*)batch_pointer(target,element,slot) = intern_string(data); }
+
+/* Records the call site of every created buffer for the registry (Needs a C99 compiler for the variadic init_bufferva) */
+#if defined(CONSTRUCT_REGISTRY) && !defined(CONSTRUCT_IMPLEMENTATION)
+    #define init_buffer(X)                              (set_registry_call_site(__FILE__,__LINE__),init_buffer(X))
+    #define init_bufferve(X,Y,Z)                        (set_registry_call_site(__FILE__,__LINE__),init_bufferve(X,Y,Z))
+    #define init_bufferva(...)                          (set_registry_call_site(__FILE__,__LINE__),init_bufferva(__VA_ARGS__))
+    #define recreate()                                  (set_registry_call_site(__FILE__,__LINE__),recreate())
+    #define recreate_buffer(X)                          (set_registry_call_site(__FILE__,__LINE__),recreate_buffer(X))
+    #define create_single_element()                     (set_registry_call_site(__FILE__,__LINE__),create_single_element())
+    #define create_single_buffer_element(X)             (set_registry_call_site(__FILE__,__LINE__),create_single_buffer_element(X))
+    #define copy_buffer(X)                              (set_registry_call_site(__FILE__,__LINE__),copy_buffer(X))
+    #define copy_buffer_cow(X)                          (set_registry_call_site(__FILE__,__LINE__),copy_buffer_cow(X))
+    #define group_buffer_by(A,B,C,D,E,F)                (set_registry_call_site(__FILE__,__LINE__),group_buffer_by(A,B,C,D,E,F))
+    #define group_by(A,B,C,D,E)                         (set_registry_call_site(__FILE__,__LINE__),group_by(A,B,C,D,E))
+    #define join_buffer(A,B,C,D,E)                      (set_registry_call_site(__FILE__,__LINE__),join_buffer(A,B,C,D,E))
+    #define join(A,B,C,D)                               (set_registry_call_site(__FILE__,__LINE__),join(A,B,C,D))
+    #define top_buffer_k(A,B,C,D)                       (set_registry_call_site(__FILE__,__LINE__),top_buffer_k(A,B,C,D))
+    #define top_buffer_k_indices(A,B,C,D)               (set_registry_call_site(__FILE__,__LINE__),top_buffer_k_indices(A,B,C,D))
+    #define top_k(A,B,C)                                (set_registry_call_site(__FILE__,__LINE__),top_k(A,B,C))
+    #define top_k_indices(A,B,C)                        (set_registry_call_site(__FILE__,__LINE__),top_k_indices(A,B,C))
+    #define distinct_buffer(A,B,C)                      (set_registry_call_site(__FILE__,__LINE__),distinct_buffer(A,B,C))
+    #define distinct(A,B)                               (set_registry_call_site(__FILE__,__LINE__),distinct(A,B))
+    #define init_appender(X,Y)                          (set_registry_call_site(__FILE__,__LINE__),init_appender(X,Y))
+    #define copy_buffer_deep(X)                         (set_registry_call_site(__FILE__,__LINE__),copy_buffer_deep(X))
+    #define load_buffer_binary_deep(X,Y)                (set_registry_call_site(__FILE__,__LINE__),load_buffer_binary_deep(X,Y))
+    #define copy_partial(X,Y)                           (set_registry_call_site(__FILE__,__LINE__),copy_partial(X,Y))
+    #define copy_partial_buffer(X,Y,Z)                  (set_registry_call_site(__FILE__,__LINE__),copy_partial_buffer(X,Y,Z))
+    #define view_partial(X,Y)                           (set_registry_call_site(__FILE__,__LINE__),view_partial(X,Y))
+    #define view_partial_buffer(X,Y,Z)                  (set_registry_call_site(__FILE__,__LINE__),view_partial_buffer(X,Y,Z))
+    #define view_partial_buffer_strided(X,Y,Z,W)        (set_registry_call_site(__FILE__,__LINE__),view_partial_buffer_strided(X,Y,Z,W))
+#endif
 
 #ifdef __cplusplus
 }
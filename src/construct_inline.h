@@ -0,0 +1,137 @@
+#ifndef CONSTRUCT_INLINE_H
+#define CONSTRUCT_INLINE_H
+
+/* Construct inline accessors
+Optional header exposing the layout of the buffers, so the hottest accessors can be inlined into the loops using them
+
+Including this header is the only way to opt in, the buffers stay opaque for everyone only including "construct.h".
+The accessors in here don't do any of the error checks, regardless of "ERROR_CHECKING" (apart from the length check of the string setters),
+and the layout is only valid for the exact version of the library it came with, so don't mix headers and libraries!
+*/
+
+#include "construct.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The dictionary of an encoded field, shared by every buffer copied, recreated or viewed from the one it was created for (codes index values and never change their meaning) */
+struct construct_dictionary
+{
+    unsigned int references,num_values,capacity,max_values,table_size;
+    long long* values;
+    unsigned int* table;
+};
+
+/* The layout of a buffer, shared with the implementation (offsets[num_types] is the element size, followed by the BIT masks, sorted_by is the ascending field plus one or 0) */
+struct buffer
+{
+    unsigned int iterator,num_types,num_elements,stride,sorted_by,num_views;
+    void* data_buffer;
+    enum construct_types* types;
+    unsigned int* offsets;
+    struct buffer* parent;
+    unsigned int* references;
+    struct construct_dictionary** dictionaries;
+    void* arena;
+    struct construct_stats stats;
+    struct buffer* registry_prev;
+    struct buffer* registry_next;
+    const char* registry_file;
+    unsigned int registry_line;
+    unsigned long peak_bytes;
+};
+
+/* Gives a buffer sharing its data buffer with a copy its own data buffer before writing to it */
+void util_prepare_write(buffer target);
+
+/* Returns the buffer owning the data of the specified buffer, which is the viewed buffer for views and the buffer itself otherwise */
+CONSTRUCT_INLINE struct buffer* util_get_root_buffer(buffer target)
+{
+    struct buffer* root = (struct buffer*)target;
+    while (root->parent != NULL)
+        root = root->parent;
+    return root;
+}
+
+/* Returns the number of elements of the specified buffer */
+CONSTRUCT_INLINE unsigned int inline_get_buffer_length(buffer target)
+{
+    return ((struct buffer*)target)->num_elements;
+}
+/* Returns the number of bytes between two consecutive elements of the specified buffer */
+CONSTRUCT_INLINE unsigned int inline_get_buffer_stride(buffer target)
+{
+    return ((struct buffer*)target)->stride;
+}
+/* Returns the number of bytes each element in the specified buffer takes */
+CONSTRUCT_INLINE unsigned int inline_get_buffer_element_size(buffer target)
+{
+    return ((struct buffer*)target)->offsets[((struct buffer*)target)->num_types];
+}
+/* Returns a pointer to the first field of the given element in the specified buffer (Only read through it, use the inline setters for writing!) */
+CONSTRUCT_INLINE void* inline_get_buffer_element_pointer(buffer target, unsigned int element)
+{
+    return (unsigned char*)((struct buffer*)target)->data_buffer + ((struct buffer*)target)->stride * element;
+}
+/* Returns a pointer to the given field of the given element in the specified buffer (Only read through it, use the inline setters for writing!) */
+CONSTRUCT_INLINE void* inline_get_buffer_pointer(buffer target, unsigned int element, unsigned int field)
+{
+    return (unsigned char*)((struct buffer*)target)->data_buffer + ((struct buffer*)target)->stride * element + ((struct buffer*)target)->offsets[field];
+}
+/* Returns a pointer to the given field of the given element in the specified buffer for writing to it */
+CONSTRUCT_INLINE void* inline_get_buffer_write_pointer(buffer target, unsigned int element, unsigned int field)
+{
+    if (util_get_root_buffer(target)->references != NULL)
+        util_prepare_write(target);
+    return inline_get_buffer_pointer(target,element,field);
+}
+
+/* Returns the given field of the specified buffer */
+CONSTRUCT_INLINE unsigned int   inline_get_buffer_fieldui(buffer target, unsigned int element, unsigned int field) { return *(unsigned int*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE int            inline_get_buffer_fieldi(buffer target, unsigned int element, unsigned int field)  { return *(int*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE float          inline_get_buffer_fieldf(buffer target, unsigned int element, unsigned int field)  { return *(float*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE char           inline_get_buffer_fieldc(buffer target, unsigned int element, unsigned int field)  { return *(char*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE unsigned char  inline_get_buffer_fielduc(buffer target, unsigned int element, unsigned int field) { return *(unsigned char*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE void*          inline_get_buffer_fieldv(buffer target, unsigned int element, unsigned int field)  { return *(void**)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE signed char         inline_get_buffer_fieldi8(buffer target, unsigned int element, unsigned int field)    { return *(signed char*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE short               inline_get_buffer_fieldi16(buffer target, unsigned int element, unsigned int field)   { return *(short*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE unsigned short      inline_get_buffer_fieldui16(buffer target, unsigned int element, unsigned int field)  { return *(unsigned short*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE long long           inline_get_buffer_fieldi64(buffer target, unsigned int element, unsigned int field)   { return *(long long*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE unsigned long long  inline_get_buffer_fieldui64(buffer target, unsigned int element, unsigned int field)  { return *(unsigned long long*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE double              inline_get_buffer_fieldd(buffer target, unsigned int element, unsigned int field)     { return *(double*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE float               inline_get_buffer_fieldh(buffer target, unsigned int element, unsigned int field)     { return half_to_float(*(unsigned short*)inline_get_buffer_pointer(target,element,field)); }
+CONSTRUCT_INLINE unsigned int        inline_get_buffer_fieldb(buffer target, unsigned int element, unsigned int field)     { return (*(unsigned char*)inline_get_buffer_pointer(target,element,field) & ((struct buffer*)target)->offsets[((struct buffer*)target)->num_types + 1 + field]) != 0; }
+CONSTRUCT_INLINE const char*         inline_get_buffer_fields(buffer target, unsigned int element, unsigned int field)     { return (const char*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE const char*         inline_get_buffer_fieldp(buffer target, unsigned int element, unsigned int field)     { return get_interned_string(*(unsigned int*)inline_get_buffer_pointer(target,element,field)); }
+CONSTRUCT_INLINE buffer              inline_get_buffer_fieldn(buffer target, unsigned int element, unsigned int field)     { return *(buffer*)inline_get_buffer_pointer(target,element,field); }
+CONSTRUCT_INLINE long long           inline_get_buffer_fielde(buffer target, unsigned int element, unsigned int field)
+{
+    unsigned int code = ((struct buffer*)target)->types[field] == DICT8 ? *(unsigned char*)inline_get_buffer_pointer(target,element,field) : *(unsigned short*)inline_get_buffer_pointer(target,element,field);
+    return ((struct buffer*)target)->dictionaries[field]->values[code];
+}
+
+/* Assigns the given field of the specified buffer to the specified data */
+CONSTRUCT_INLINE void inline_set_buffer_fieldui(buffer target, unsigned int element, unsigned int field, unsigned int data)  { *(unsigned int*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldi(buffer target, unsigned int element, unsigned int field, int data)            { *(int*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldf(buffer target, unsigned int element, unsigned int field, float data)          { *(float*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldc(buffer target, unsigned int element, unsigned int field, char data)           { *(char*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fielduc(buffer target, unsigned int element, unsigned int field, unsigned char data) { *(unsigned char*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldv(buffer target, unsigned int element, unsigned int field, void* data)          { *(void**)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldi8(buffer target, unsigned int element, unsigned int field, signed char data)     { *(signed char*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldi16(buffer target, unsigned int element, unsigned int field, short data)          { *(short*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldui16(buffer target, unsigned int element, unsigned int field, unsigned short data) { *(unsigned short*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldi64(buffer target, unsigned int element, unsigned int field, long long data)      { *(long long*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldui64(buffer target, unsigned int element, unsigned int field, unsigned long long data) { *(unsigned long long*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldd(buffer target, unsigned int element, unsigned int field, double data)           { *(double*)inline_get_buffer_write_pointer(target,element,field) = data; }
+CONSTRUCT_INLINE void inline_set_buffer_fieldh(buffer target, unsigned int element, unsigned int field, float data)            { *(unsigned short*)inline_get_buffer_write_pointer(target,element,field) = float_to_half(data); }
+CONSTRUCT_INLINE void inline_set_buffer_fieldb(buffer target, unsigned int element, unsigned int field, unsigned int data)      { set_bit_field((unsigned char*)inline_get_buffer_write_pointer(target,element,field),((struct buffer*)target)->offsets[((struct buffer*)target)->num_types + 1 + field],data); }
+CONSTRUCT_INLINE void inline_set_buffer_fields(buffer target, unsigned int element, unsigned int field, const char* data)   { set_string_field((char*)inline_get_buffer_write_pointer(target,element,field),((struct buffer*)target)->types[field] == STR32 ? 32 : 16,data); }
+CONSTRUCT_INLINE void inline_set_buffer_fieldp(buffer target, unsigned int element, unsigned int field, const char* data)   { *(unsigned int*)inline_get_buffer_write_pointer(target,element,field) = intern_string(data); }
+CONSTRUCT_INLINE void inline_set_buffer_fieldn(buffer target, unsigned int element, unsigned int field, buffer data)       { *(buffer*)inline_get_buffer_write_pointer(target,element,field) = data; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONSTRUCT_INLINE_H */